@@ -0,0 +1,3098 @@
+#ifndef BASIC_CONTROLLER_MANAGER_H
+#define BASIC_CONTROLLER_MANAGER_H
+
+/**
+*	Member definitions of BasicControllerManager.
+*
+*	ControllerManager (default instantiation) is instantiated in ControllerManager.cpp, so users of it only
+*	include ControllerManager.h. Include this in one source file to instantiate manager with other policies.
+*/
+
+#include "ControllerManager.h"
+#include "StickProcessor.h"
+#include "SharedState.h"
+#include <fstream>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#define CONTROLLER_MANAGER_POLL
+#endif
+
+// Platforms where SDL_JoystickUpdate can be called from thread other than one that initialized joysticks
+#if defined(_WIN32) || defined(__linux__)
+#define CONTROLLER_MANAGER_FAST_PATH_PUMP
+#endif
+
+// Max number of input source fds waited by waitForInput
+#define MAX_WAIT_SOURCE 8
+// Milliseconds between SDL queue checks while waiting on input source fds
+#define SOURCE_WAIT_SLICE 1
+
+/**
+*	Calibration profile file format. All values are little endian.
+*	Header: "CMCP" (4 bytes), version (Uint16), profile count (Uint16)
+*	Profile: GUID (16 bytes), calibrated axis mask (Uint8), reserved (Uint8), center (Sint16 * 6), deadzone (Sint16 * 6)
+*/
+#define CALIBRATION_FILE_MAGIC "CMCP"
+#define CALIBRATION_FILE_VERSION 1
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>* BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::instance = nullptr;
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::BasicControllerManager()
+	: seatCount(0),
+	fastPathListenerCount(0),
+	fastPathEnabled(false),
+	fastPathPumpThread(nullptr),
+	fastPathPumpRunning(false),
+	fastPathPumpInterval(0),
+	calibrationProfilesDirty(false),
+	autoCalibration(false),
+	stickDeadzoneMode(IO::XBOX_360::DEADZONE::AXIAL),
+	outerDeadzone(1.0f),
+	antiDeadzone(0),
+	nextExternalID(EXTERNAL_CONTROLLER_ID_BEGIN),
+	sharedStateWriter(nullptr),
+	sharedStatePublished(0),
+	timedWaitList(nullptr),
+	nextWaitDeadline(0),
+	readyWaitList(nullptr)
+{
+	resetMetrics();
+
+	for (int i = 0; i < MAX_FAST_PATH_CONTROLLER; i++)
+	{
+		fastPathSlots[i].id.store(-1);
+		fastPathSlots[i].buttons.store(0);
+		fastPathSlots[i].timestamp.store(0);
+	}
+
+	// Enough for all seats, or 16 controllers if unlimited, without reallocation
+	const int seats = (SeatPolicy::CAPACITY >= 0) ? SeatPolicy::CAPACITY : 16;
+	pendingStickControllers.reserve(seats);
+	stickX.reserve(seats * 2);
+	stickY.reserve(seats * 2);
+	stickDeadzone.reserve(seats * 2);
+	stickOwner.reserve(seats * 2);
+	changeJournal.reserve(256);
+	dirtyControllers.reserve(seats);
+
+	// Clear wait lists
+	for (int i = 0; i < IO::XBOX_360::BUTTON_COUNT; i++)
+	{
+		buttonWaitList[i] = nullptr;
+	}
+
+	for (int i = 0; i < IO::XBOX_360::AXIS_COUNT; i++)
+	{
+		axisWaitList[i] = nullptr;
+	}
+
+	//Initialize SDL
+	if (SDL_Init(SDL_INIT_GAMECONTROLLER | HapticPolicy::INIT_FLAGS) < 0)
+	{
+		LogPolicy::write(HapticPolicy::ENABLED ? "SDL_INIT_GAMECONTROLLER or SDL_INIT_HAPTIC could not initialize!SDL Error : " : "SDL_INIT_GAMECONTROLLER could not initialize!SDL Error : ", SDL_GetError());
+		active = false;
+	}
+	else
+	{
+		LogPolicy::write("SDL is initilized");
+		active = true;
+
+		// Untracked controller inputs never reach the queue. Joystick events can't be ignored
+		// because SDL derives game controller events from them, so profile filters them in handleEvent.
+		if (!ProfilePolicy::HAS_BUTTONS)
+		{
+			SDL_EventState(SDL_CONTROLLERBUTTONDOWN, SDL_IGNORE);
+			SDL_EventState(SDL_CONTROLLERBUTTONUP, SDL_IGNORE);
+		}
+
+		if (!ProfilePolicy::HAS_AXES)
+		{
+			SDL_EventState(SDL_CONTROLLERAXISMOTION, SDL_IGNORE);
+		}
+	}
+
+	// Register event type for waking up waitForInput from other thread
+	wakeUpEventType = active ? SDL_RegisterEvents(1) : static_cast<Uint32>(-1);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::~BasicControllerManager()
+{
+	disableFastPath();
+	disableSharedStateExport();
+
+	// Detach waiting groups. They will never be resumed.
+	for (int i = 0; i < IO::XBOX_360::BUTTON_COUNT; i++)
+	{
+		for (InputWaiter* waiter = buttonWaitList[i]; waiter != nullptr; waiter = waiter->next)
+		{
+			waiter->linked = false;
+			waiter->group->owner = nullptr;
+		}
+	}
+
+	for (int i = 0; i < IO::XBOX_360::AXIS_COUNT; i++)
+	{
+		for (InputWaiter* waiter = axisWaitList[i]; waiter != nullptr; waiter = waiter->next)
+		{
+			waiter->linked = false;
+			waiter->group->owner = nullptr;
+		}
+	}
+
+	for (InputWaitGroup* group = timedWaitList; group != nullptr; group = group->timerNext)
+	{
+		group->owner = nullptr;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>* BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getInstance()
+{
+	if (instance == nullptr)
+	{
+		instance = new BasicControllerManager();
+	}
+
+	return instance;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::deleteInstance()
+{
+	//check if instance is alive pointer
+	if (instance != nullptr)
+	{
+		delete instance;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::update()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	beginFrame();
+	processEvents();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::beginFrame()
+{
+	for (auto id : dirtyControllers)
+	{
+		Controller* controller = findController(id);
+		if (controller != nullptr)
+		{
+			controller->dirty = false;
+			controller->dirtyButtons = 0;
+			controller->dirtyAxes = 0;
+			controller->dirtyJoystickAxes = 0;
+
+			for (auto& bits : controller->joystickDirtyButtonBits)
+			{
+				bits = 0;
+			}
+		}
+	}
+
+	// Changes made between updates (e.g. external controller added from outside)
+	if (sharedStateWriter != nullptr && changeJournal.size() != sharedStatePublished)
+	{
+		publishSharedState();
+	}
+
+	dirtyControllers.clear();
+	changeJournal.clear();
+	sharedStatePublished = 0;
+
+	this->beginDispatch();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::processEvents(const SDL_Event* firstEvent)
+{
+	const Uint64 start = SDL_GetPerformanceCounter();
+
+	SDL_Event e;
+	bool hasEvent = false;
+	if (firstEvent != nullptr)
+	{
+		e = *firstEvent;
+		hasEvent = true;
+	}
+	else
+	{
+		hasEvent = (SDL_PollEvent(&e) != 0);
+	}
+
+	if (hasEvent)
+	{
+		// Queue is pumped by now. Count first event and rest of queue.
+		metrics.queueDepth = 1 + static_cast<Uint32>(SDL_max(SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT), 0));
+		metrics.maxQueueDepth = SDL_max(metrics.maxQueueDepth, metrics.queueDepth);
+	}
+	else
+	{
+		metrics.queueDepth = 0;
+	}
+
+	while (hasEvent)
+	{
+		handleEvent(e);
+		hasEvent = (SDL_PollEvent(&e) != 0);
+	}
+
+	for (auto source : inputSources)
+	{
+		source->pollInput(this);
+	}
+
+	if (ProfilePolicy::HAS_AXES && !calibratingControllers.empty())
+	{
+		processCalibration();
+	}
+
+	if (ProfilePolicy::HAS_AXES && !pendingStickControllers.empty())
+	{
+		processSticks();
+	}
+
+	if (timedWaitList != nullptr)
+	{
+		resumeTimedOutWaiters();
+	}
+
+	if (sharedStateWriter != nullptr && changeJournal.size() != sharedStatePublished)
+	{
+		publishSharedState();
+	}
+
+	const Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+	metrics.updates++;
+	metrics.updateTime += elapsed;
+	metrics.lastUpdateTime = elapsed;
+	metrics.maxUpdateTime = SDL_max(metrics.maxUpdateTime, elapsed);
+	metrics.lastUpdateTicks = SDL_GetTicks();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::waitForInput(const int timeout)
+{
+	SDL_Event e;
+	int result = 0;
+
+	int waitTimeout = timeout;
+	int fds[MAX_WAIT_SOURCE];
+	int fdCount = 0;
+
+	// Lock isn't held while sleeping, so other threads can query manager meanwhile
+	{
+		typename ThreadingPolicy::Guard guard(mutex);
+
+		beginFrame();
+
+		// Don't sleep past the closest wait deadline
+		const int deadlineTimeout = getWaitDeadlineTimeout();
+		if (deadlineTimeout >= 0 && (waitTimeout < 0 || deadlineTimeout < waitTimeout))
+		{
+			waitTimeout = deadlineTimeout;
+		}
+
+		// Don't sleep past input due from input sources (e.g. recording)
+		for (auto source : inputSources)
+		{
+			const int sourceTimeout = source->getWaitTimeout();
+			if (sourceTimeout >= 0 && (waitTimeout < 0 || sourceTimeout < waitTimeout))
+			{
+				waitTimeout = sourceTimeout;
+			}
+
+			const int fd = source->getWaitFD();
+			if (fd >= 0 && fdCount < MAX_WAIT_SOURCE)
+			{
+				fds[fdCount] = fd;
+				fdCount++;
+			}
+		}
+	}
+
+	if (fdCount > 0)
+	{
+		result = waitEventOrSource(e, fds, fdCount, waitTimeout);
+	}
+	else if (waitTimeout < 0)
+	{
+		result = SDL_WaitEvent(&e);
+	}
+	else
+	{
+		result = SDL_WaitEventTimeout(&e, waitTimeout);
+	}
+
+	// Handle event that woke us up with rest of events that arrived meanwhile, and timed out waiters.
+	// Input of sources is read by processEvents too.
+	typename ThreadingPolicy::Guard guard(mutex);
+	processEvents(result == 1 ? &e : nullptr);
+
+	// 0 if timed out (or error)
+	return result != 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::waitEventOrSource(SDL_Event& e, const int* fds, const int count, const int timeout)
+{
+#if defined(CONTROLLER_MANAGER_POLL)
+	struct pollfd pollFDs[MAX_WAIT_SOURCE];
+	for (int i = 0; i < count; i++)
+	{
+		pollFDs[i].fd = fds[i];
+		pollFDs[i].events = POLLIN;
+		pollFDs[i].revents = 0;
+	}
+
+	const Uint32 start = SDL_GetTicks();
+
+	while (true)
+	{
+		// Pumps SDL events too
+		if (SDL_PollEvent(&e) != 0)
+		{
+			return 1;
+		}
+
+		// SDL queue can't be waited together with fd, so it's checked every slice
+		int slice = SOURCE_WAIT_SLICE;
+		if (timeout >= 0)
+		{
+			const int elapsed = static_cast<int>(SDL_GetTicks() - start);
+			if (elapsed >= timeout)
+			{
+				return 0;
+			}
+
+			slice = SDL_min(slice, timeout - elapsed);
+		}
+
+		if (poll(pollFDs, count, slice) > 0)
+		{
+			return 2;
+		}
+	}
+#else
+	(void)fds;
+	(void)count;
+	return (timeout < 0) ? SDL_WaitEvent(&e) : SDL_WaitEventTimeout(&e, timeout);
+#endif
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::wakeUp()
+{
+	if (wakeUpEventType == static_cast<Uint32>(-1))
+	{
+		return;
+	}
+
+	SDL_Event e;
+	SDL_zero(e);
+	e.type = wakeUpEventType;
+	SDL_PushEvent(&e);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::addInputSource(InputSource* source)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (source == nullptr)
+	{
+		return;
+	}
+
+	for (auto registered : inputSources)
+	{
+		if (registered == source)
+		{
+			return;
+		}
+	}
+
+	inputSources.push_back(source);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::removeInputSource(InputSource* source)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	for (auto it = inputSources.begin(); it != inputSources.end(); ++it)
+	{
+		if (*it == source)
+		{
+			inputSources.erase(it);
+			return;
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const ControllerID BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::addExternalController(const std::string& name)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (SeatPolicy::CAPACITY >= 0 && seatCount >= SeatPolicy::CAPACITY)
+	{
+		LogPolicy::write("All seats are taken. External controller is ignored : ", name.c_str());
+		return -1;
+	}
+
+	// Find unused id, wrapping around at the end of range
+	ControllerID id = -1;
+	for (int i = 0; i <= EXTERNAL_CONTROLLER_ID_END - EXTERNAL_CONTROLLER_ID_BEGIN; i++)
+	{
+		const ControllerID candidate = nextExternalID;
+		nextExternalID = (candidate >= EXTERNAL_CONTROLLER_ID_END) ? EXTERNAL_CONTROLLER_ID_BEGIN : candidate + 1;
+
+		if (findController(candidate) == nullptr)
+		{
+			id = candidate;
+			break;
+		}
+	}
+
+	if (id < 0)
+	{
+		return -1;
+	}
+
+	Controller* controller = new Controller(nullptr, nullptr, nullptr, name, id, IO::XBOX_360::BUTTON_COUNT, IO::XBOX_360::AXIS_COUNT, 0);
+	this->controllers[id] = controller;
+	seatCount++;
+	assignFastPathSlot(id);
+
+	metrics.connections++;
+	recordChange(controller, IO::INPUT_TYPE::CONNECTION, 0, 0, 1.0f);
+
+	this->notifyConnected(controller, id, true);
+
+	return id;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::removeExternalController(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (id >= EXTERNAL_CONTROLLER_ID_BEGIN)
+	{
+		removeController(id);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::claimDevice(const Uint16 vendor, const Uint16 product)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	for (auto& claim : deviceClaims)
+	{
+		if (claim.vendor == vendor && claim.product == product)
+		{
+			claim.count++;
+			return;
+		}
+	}
+
+	DeviceClaim claim;
+	claim.vendor = vendor;
+	claim.product = product;
+	claim.count = 1;
+	deviceClaims.push_back(claim);
+
+	// Remove SDL controllers and joysticks of this model that are already added
+	std::vector<ControllerID> claimed;
+	for (auto& entry : controllers)
+	{
+		Controller* controller = entry.second;
+		if (controller == nullptr)
+		{
+			continue;
+		}
+
+		SDL_Joystick* joy = (controller->controller != nullptr) ? SDL_GameControllerGetJoystick(controller->controller) : controller->joystick;
+		if (joy != nullptr && SDL_JoystickGetVendor(joy) == vendor && SDL_JoystickGetProduct(joy) == product)
+		{
+			claimed.push_back(entry.first);
+		}
+	}
+
+	for (auto id : claimed)
+	{
+		removeController(id);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::releaseDevice(const Uint16 vendor, const Uint16 product)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	for (auto it = deviceClaims.begin(); it != deviceClaims.end(); ++it)
+	{
+		if (it->vendor == vendor && it->product == product)
+		{
+			it->count--;
+			if (it->count > 0)
+			{
+				return;
+			}
+
+			deviceClaims.erase(it);
+			break;
+		}
+	}
+
+	if (!active)
+	{
+		return;
+	}
+
+	// Let SDL report this model again. Already added devices are skipped by addDeviceIndex.
+	const int count = SDL_NumJoysticks();
+	for (int i = 0; i < count; i++)
+	{
+		if (SDL_JoystickGetDeviceVendor(i) == vendor && SDL_JoystickGetDeviceProduct(i) == product)
+		{
+			addDeviceIndex(i);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isClaimedDevice(const Uint16 vendor, const Uint16 product)
+{
+	for (auto& claim : deviceClaims)
+	{
+		if (claim.vendor == vendor && claim.product == product)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isClaimedDeviceIndex(const int deviceIndex)
+{
+	if (deviceClaims.empty())
+	{
+		return false;
+	}
+
+	return isClaimedDevice(SDL_JoystickGetDeviceVendor(deviceIndex), SDL_JoystickGetDeviceProduct(deviceIndex));
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::addDeviceIndex(const int deviceIndex)
+{
+	if (findController(SDL_JoystickGetDeviceInstanceID(deviceIndex)) != nullptr)
+	{
+		return;
+	}
+
+	if (SDL_IsGameController(deviceIndex))
+	{
+		SDL_ControllerDeviceEvent event;
+		SDL_zero(event);
+		event.type = SDL_CONTROLLERDEVICEADDED;
+		event.which = deviceIndex;
+		addController(event);
+	}
+	else
+	{
+		SDL_JoyDeviceEvent event;
+		SDL_zero(event);
+		event.type = SDL_JOYDEVICEADDED;
+		event.which = deviceIndex;
+		addJoystick(event);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::injectEvent(const SDL_Event& e)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (fastPathEnabled)
+	{
+		SDL_Event copy = e;
+		fastPathWatch(this, &copy);
+	}
+
+	handleEvent(e);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::handleEvent(const SDL_Event& e)
+{
+	if ((e.type >= SDL_CONTROLLERAXISMOTION && e.type <= SDL_CONTROLLERDEVICEREMAPPED) || (e.type >= SDL_JOYAXISMOTION && e.type <= SDL_JOYDEVICEREMOVED))
+	{
+		metrics.lastEventTicks = SDL_GetTicks();
+	}
+
+	switch (e.type)
+	{
+	case SDL_CONTROLLERDEVICEADDED:
+	{
+		addController(e.cdevice);
+	}
+	break;
+	case SDL_CONTROLLERDEVICEREMOVED:
+	{
+		removeController(e.cdevice.which);
+	}
+	break;
+	case SDL_CONTROLLERBUTTONDOWN:
+	{
+		if (ProfilePolicy::HAS_BUTTONS)
+		{
+			buttonPressed(e.cdevice.which, e.cbutton);
+		}
+	}
+	break;
+	case SDL_CONTROLLERBUTTONUP:
+	{
+		if (ProfilePolicy::HAS_BUTTONS)
+		{
+			buttonReleased(e.cdevice.which, e.cbutton);
+		}
+	}
+	break;
+	case SDL_CONTROLLERAXISMOTION:
+	{
+		if (ProfilePolicy::HAS_AXES)
+		{
+			axisMoved(e.cdevice.which, e.caxis);
+		}
+	}
+	break;
+	case SDL_JOYDEVICEADDED:
+	{
+		addJoystick(e.jdevice);
+	}
+	break;
+	case SDL_JOYDEVICEREMOVED:
+	{
+		// Game controllers are removed by SDL_CONTROLLERDEVICEREMOVED
+		Controller* controller = findController(e.jdevice.which);
+		if (controller != nullptr && controller->joystick != nullptr)
+		{
+			removeController(e.jdevice.which);
+		}
+	}
+	break;
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+	{
+		if (ProfilePolicy::HAS_JOYSTICKS)
+		{
+			joystickButtonChanged(e.jbutton);
+		}
+	}
+	break;
+	case SDL_JOYAXISMOTION:
+	{
+		if (ProfilePolicy::HAS_JOYSTICKS)
+		{
+			joystickAxisMoved(e.jaxis);
+		}
+	}
+	break;
+	case SDL_JOYHATMOTION:
+	{
+		if (ProfilePolicy::HAS_JOYSTICKS)
+		{
+			joystickHatMoved(e.jhat);
+		}
+	}
+	break;
+	default:
+		// Includes wake up event. Nothing to do.
+		break;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::addController(const SDL_ControllerDeviceEvent event)
+{
+	if (isClaimedDeviceIndex(event.which))
+	{
+		// Input source reports this pad
+		return;
+	}
+
+	if (SDL_IsGameController(event.which)) {
+		// Get as controller
+		SDL_GameController* newController = SDL_GameControllerOpen(event.which);
+
+		if (newController != nullptr) {
+			// Convert to joystick
+			SDL_Joystick *joy = SDL_GameControllerGetJoystick(newController);
+			// Get instance id
+			const ControllerID instanceID = SDL_JoystickInstanceID(joy);
+
+			// Check duplication. Removed controller leaves nullptr, and SDL keeps instance id when released claim re-adds it.
+			auto find_it = this->controllers.find(instanceID);
+			if (find_it == this->controllers.end() || find_it->second == nullptr)
+			{
+				if (SeatPolicy::CAPACITY >= 0 && seatCount >= SeatPolicy::CAPACITY)
+				{
+					// Added by fillFreeSeats when seat becomes free
+					LogPolicy::write("All seats are taken. Controller is ignored : ", SDL_JoystickName(joy));
+					SDL_GameControllerClose(newController);
+					return;
+				}
+
+				// Get number of button and axis on controller
+				const int buttonCount = SDL_JoystickNumButtons(joy);
+				const int axisCount = SDL_JoystickNumAxes(joy);
+				// Get name
+				std::string name = std::string(SDL_JoystickName(joy));
+
+				bool rumbleEnabled = false;
+				SDL_Haptic* newHaptic = HapticPolicy::open(joy, rumbleEnabled);
+
+				const int hatCount = SDL_JoystickNumHats(joy);
+
+				Controller* controller = new Controller(newController, nullptr, newHaptic, name, instanceID, buttonCount, axisCount, hatCount);
+				controller->hapticEnabled = rumbleEnabled;
+				controller->guid = SDL_JoystickGetGUID(joy);
+
+				// Returning controller gets its calibration instantly
+				if (!applyCalibrationProfile(controller) && autoCalibration)
+				{
+					beginCalibration(controller);
+				}
+
+				this->controllers[instanceID] = controller;
+				seatCount++;
+				assignFastPathSlot(instanceID);
+
+				metrics.connections++;
+				recordChange(controller, IO::INPUT_TYPE::CONNECTION, 0, 0, 1.0f);
+
+				this->notifyConnected(controller, instanceID, true);
+			}
+			else
+			{
+				// Controller with same id already exists
+				return;
+			}
+		}
+		else
+		{
+			// New controller is invalid
+			return;
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::addJoystick(const SDL_JoyDeviceEvent event)
+{
+	if (!ProfilePolicy::HAS_JOYSTICKS || SDL_IsGameController(event.which))
+	{
+		// Not tracked, or handled by addController
+		return;
+	}
+
+	if (isClaimedDeviceIndex(event.which))
+	{
+		return;
+	}
+
+	SDL_Joystick* joy = SDL_JoystickOpen(event.which);
+	if (joy == nullptr)
+	{
+		// New joystick is invalid
+		return;
+	}
+
+	const ControllerID instanceID = SDL_JoystickInstanceID(joy);
+
+	// Check duplication
+	auto find_it = this->controllers.find(instanceID);
+	if (find_it != this->controllers.end() && find_it->second != nullptr)
+	{
+		SDL_JoystickClose(joy);
+		return;
+	}
+
+	if (SeatPolicy::CAPACITY >= 0 && seatCount >= SeatPolicy::CAPACITY)
+	{
+		LogPolicy::write("All seats are taken. Joystick is ignored : ", SDL_JoystickName(joy));
+		SDL_JoystickClose(joy);
+		return;
+	}
+
+	const int buttonCount = SDL_JoystickNumButtons(joy);
+	const int axisCount = SDL_JoystickNumAxes(joy);
+	const int hatCount = SDL_JoystickNumHats(joy);
+	const char* joyName = SDL_JoystickName(joy);
+	std::string name = std::string(joyName != nullptr ? joyName : "");
+
+	bool rumbleEnabled = false;
+	SDL_Haptic* newHaptic = HapticPolicy::open(joy, rumbleEnabled);
+
+	Controller* controller = new Controller(nullptr, joy, newHaptic, name, instanceID, buttonCount, axisCount, hatCount);
+	controller->hapticEnabled = rumbleEnabled;
+	controller->guid = SDL_JoystickGetGUID(joy);
+
+	this->controllers[instanceID] = controller;
+	seatCount++;
+
+	metrics.connections++;
+	recordChange(controller, IO::INPUT_TYPE::CONNECTION, 0, 0, 1.0f);
+
+	this->notifyConnected(controller, instanceID, true);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::removeController(ControllerID id)
+{
+	auto find_it = this->controllers.find(id);
+
+	if (find_it != this->controllers.end() && find_it->second != nullptr)
+	{
+		Controller* controller = find_it->second;
+
+		metrics.disconnections++;
+		recordChange(controller, IO::INPUT_TYPE::CONNECTION, 0, 1.0f, 0);
+
+		this->notifyConnected(controller, id, false);
+
+		releaseFastPathSlot(id);
+		HapticPolicy::close(controller->haptic);
+		delete controller;
+
+		this->controllers[id] = nullptr;
+		seatCount--;
+
+		// Device that was ignored while seats were full takes freed seat
+		if (SeatPolicy::CAPACITY >= 0)
+		{
+			fillFreeSeats();
+		}
+	}
+	else
+	{
+		this->controllers[id] = nullptr;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::fillFreeSeats()
+{
+	if (!active)
+	{
+		return;
+	}
+
+	// Already added and claimed devices are skipped by addDeviceIndex
+	const int count = SDL_NumJoysticks();
+	for (int i = 0; i < count && seatCount < SeatPolicy::CAPACITY; i++)
+	{
+		addDeviceIndex(i);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::joystickButtonChanged(const SDL_JoyButtonEvent event)
+{
+	Controller* controller = findController(event.which);
+	if (controller != nullptr && controller->joystick == nullptr)
+	{
+		// Game controller. Handled by buttonPressed/buttonReleased.
+		return;
+	}
+
+	const bool pressed = (event.state == SDL_PRESSED);
+
+	if (pressed)
+	{
+		metrics.total.buttonDownEvents++;
+	}
+	else
+	{
+		metrics.total.buttonUpEvents++;
+	}
+
+	if (controller == nullptr)
+	{
+		metrics.droppedEvents++;
+		return;
+	}
+
+	if (pressed)
+	{
+		controller->metrics.buttonDownEvents++;
+	}
+	else
+	{
+		controller->metrics.buttonUpEvents++;
+	}
+
+	if (event.button >= controller->buttonCount)
+	{
+		countIgnoredEvent(controller);
+		return;
+	}
+
+	dispatchJoystickButton(controller, event.button, pressed);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::joystickAxisMoved(const SDL_JoyAxisEvent event)
+{
+	Controller* controller = findController(event.which);
+	if (controller != nullptr && controller->joystick == nullptr)
+	{
+		// Game controller. Handled by axisMoved.
+		return;
+	}
+
+	metrics.total.axisEvents++;
+
+	if (controller == nullptr)
+	{
+		metrics.droppedEvents++;
+		return;
+	}
+
+	controller->metrics.axisEvents++;
+
+	if (event.axis >= controller->joystickAxisValues.size())
+	{
+		countIgnoredEvent(controller);
+		return;
+	}
+
+	const float newValue = controller->getAxisValue(event.value);
+	const float oldValue = controller->joystickAxisValues[event.axis];
+	controller->joystickAxisValues[event.axis] = newValue;
+
+	if (oldValue != newValue)
+	{
+		recordChange(controller, IO::INPUT_TYPE::JOYSTICK_AXIS, event.axis, oldValue, newValue);
+	}
+
+	if (newValue != 0)
+	{
+		this->notifyJoystickAxis(controller, controller->id, event.axis, newValue);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::joystickHatMoved(const SDL_JoyHatEvent event)
+{
+	Controller* controller = findController(event.which);
+	if (controller != nullptr && controller->joystick == nullptr)
+	{
+		// Game controller. Dpad is handled as controller buttons.
+		return;
+	}
+
+	if (controller == nullptr)
+	{
+		metrics.droppedEvents++;
+		return;
+	}
+
+	if (event.hat >= controller->joystickHatValues.size())
+	{
+		countIgnoredEvent(controller);
+		return;
+	}
+
+	const Uint8 oldValue = controller->joystickHatValues[event.hat];
+	controller->joystickHatValues[event.hat] = event.value;
+
+	if (oldValue != event.value)
+	{
+		recordChange(controller, IO::INPUT_TYPE::JOYSTICK_HAT, event.hat, oldValue, event.value);
+	}
+
+	// Each changed direction is pressed or released as button
+	const Uint8 directions[4] = { SDL_HAT_UP, SDL_HAT_RIGHT, SDL_HAT_DOWN, SDL_HAT_LEFT };
+	for (int i = 0; i < 4; i++)
+	{
+		const bool wasPressed = (oldValue & directions[i]) != 0;
+		const bool pressed = (event.value & directions[i]) != 0;
+
+		if (wasPressed != pressed)
+		{
+			if (pressed)
+			{
+				metrics.total.buttonDownEvents++;
+				controller->metrics.buttonDownEvents++;
+			}
+			else
+			{
+				metrics.total.buttonUpEvents++;
+				controller->metrics.buttonUpEvents++;
+			}
+
+			dispatchJoystickButton(controller, controller->buttonCount + event.hat * 4 + i, pressed);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::dispatchJoystickButton(Controller* controller, const int button, const bool pressed)
+{
+	const bool wasPressed = controller->getJoystickButton(button);
+	controller->setJoystickButton(button, pressed);
+
+	if (wasPressed != pressed)
+	{
+		recordChange(controller, IO::INPUT_TYPE::JOYSTICK_BUTTON, button, wasPressed ? 1.0f : 0, pressed ? 1.0f : 0);
+	}
+
+	this->notifyJoystickButton(controller, controller->id, button, pressed);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::buttonPressed(ControllerID id, const SDL_ControllerButtonEvent event)
+{
+	if (event.state == SDL_PRESSED)
+	{
+		Controller* controller = findController(id);
+		metrics.total.buttonDownEvents++;
+
+		// Unknown controller's button still reaches callbacks with its id
+		if (controller == nullptr)
+		{
+			metrics.unknownControllerEvents++;
+		}
+		else
+		{
+			controller->metrics.buttonDownEvents++;
+		}
+
+		// Virtual buttons can't be pressed by device
+		if (event.button >= IO::XBOX_360::VIRTUAL_BUTTON_BEGIN)
+		{
+			countIgnoredEvent(controller);
+			return;
+		}
+
+		IO::XBOX_360::BUTTON buttonEnum = static_cast<IO::XBOX_360::BUTTON>(event.button);
+		if (controller != nullptr && !controller->hasButton(buttonEnum))
+		{
+			countIgnoredEvent(controller);
+			return;
+		}
+
+		dispatchButton(controller, id, buttonEnum, true);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::buttonReleased(ControllerID id, const SDL_ControllerButtonEvent event)
+{
+	if (event.state == SDL_RELEASED)
+	{
+		Controller* controller = findController(id);
+		metrics.total.buttonUpEvents++;
+
+		// Unknown controller's button still reaches callbacks with its id
+		if (controller == nullptr)
+		{
+			metrics.unknownControllerEvents++;
+		}
+		else
+		{
+			controller->metrics.buttonUpEvents++;
+		}
+
+		if (event.button >= IO::XBOX_360::VIRTUAL_BUTTON_BEGIN)
+		{
+			countIgnoredEvent(controller);
+			return;
+		}
+
+		IO::XBOX_360::BUTTON buttonEnum = static_cast<IO::XBOX_360::BUTTON>(event.button);
+		if (controller != nullptr && !controller->hasButton(buttonEnum))
+		{
+			countIgnoredEvent(controller);
+			return;
+		}
+
+		dispatchButton(controller, id, buttonEnum, false);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::dispatchButton(Controller* controller, ControllerID id, IO::XBOX_360::BUTTON button, const bool pressed)
+{
+	if (controller != nullptr && controller->hasButton(button))
+	{
+		const bool wasPressed = controller->buttonStateMap[button];
+		controller->updateButtonState(button, pressed);
+
+		if (wasPressed != pressed)
+		{
+			recordChange(controller, IO::INPUT_TYPE::BUTTON, static_cast<int>(button), wasPressed ? 1.0f : 0, pressed ? 1.0f : 0);
+		}
+	}
+
+	this->notifyButton(controller, id, button, pressed);
+
+	if (pressed)
+	{
+		resumeButtonWaiters(id, button);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::updateVirtualButtons(Controller* controller, ControllerID id, IO::XBOX_360::AXIS axis, const float value)
+{
+	for (int i = 0; i < IO::XBOX_360::VIRTUAL_BUTTON_COUNT; i++)
+	{
+		const Controller::VirtualButton& virtualButton = controller->virtualButtons[i];
+		if (virtualButton.axis != axis)
+		{
+			continue;
+		}
+
+		const IO::XBOX_360::BUTTON button = static_cast<IO::XBOX_360::BUTTON>(IO::XBOX_360::VIRTUAL_BUTTON_BEGIN + i);
+		const bool pressed = controller->buttonStateMap[button];
+		const float directedValue = value * virtualButton.direction;
+
+		if (!pressed && directedValue >= virtualButton.pressThreshold)
+		{
+			dispatchButton(controller, id, button, true);
+		}
+		else if (pressed && directedValue < virtualButton.releaseThreshold)
+		{
+			dispatchButton(controller, id, button, false);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::axisMoved(ControllerID id, const SDL_ControllerAxisEvent event)
+{
+	Controller* controller = findController(id);
+	metrics.total.axisEvents++;
+
+	if (controller == nullptr)
+	{
+		metrics.droppedEvents++;
+		return;
+	}
+
+	controller->metrics.axisEvents++;
+
+	IO::XBOX_360::AXIS axis = static_cast<IO::XBOX_360::AXIS>(event.axis);
+	if (!controller->hasAxis(axis))
+	{
+		countIgnoredEvent(controller);
+		return;
+	}
+
+	ControllerID value = event.value;
+
+	// Keep raw stick value in every mode, so switching to radial mode has both X and Y
+	if (static_cast<int>(axis) < 4)
+	{
+		controller->stickRawValue[static_cast<int>(axis)] = value;
+	}
+
+	// Radial deadzone needs both X and Y. Defer stick to processSticks.
+	if (stickDeadzoneMode != IO::XBOX_360::DEADZONE::AXIAL && static_cast<int>(axis) < 4)
+	{
+		if (!controller->stickPending)
+		{
+			controller->stickPending = true;
+			pendingStickControllers.push_back(id);
+		}
+
+		return;
+	}
+
+	// Modifier determine whether axis is x or y. x = 1.0, y = -1.0
+	float modifier = 0;
+	float newValue = 0;
+
+	if (axis == IO::XBOX_360::AXIS::L_AXIS_X || axis == IO::XBOX_360::AXIS::R_AXIS_X)
+	{
+		modifier = 1.0f;
+		newValue = controller->getAxisValue(axis, value, modifier);
+	}
+	else if (axis == IO::XBOX_360::AXIS::L_AXIS_Y || axis == IO::XBOX_360::AXIS::R_AXIS_Y)
+	{
+		modifier = -1.0f;
+		newValue = controller->getAxisValue(axis, value, modifier);
+	}
+
+	if (axis == IO::XBOX_360::AXIS::LT || axis == IO::XBOX_360::AXIS::RT)
+	{
+		newValue = controller->getAxisValue(axis, value);
+	}
+
+	applyAxisValue(controller, id, axis, newValue);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::applyAxisValue(Controller* controller, ControllerID id, IO::XBOX_360::AXIS axis, const float newValue)
+{
+	if (controller->hasAxis(axis))
+	{
+		const float oldValue = controller->axisValueMap[axis];
+		controller->updateAxisValue(axis, newValue);
+
+		if (oldValue != newValue)
+		{
+			recordChange(controller, IO::INPUT_TYPE::AXIS, static_cast<int>(axis), oldValue, newValue);
+		}
+	}
+
+	if (newValue != 0)
+	{
+		this->notifyAxis(controller, id, axis, newValue);
+	}
+
+	resumeAxisWaiters(id, axis, newValue);
+
+	if (ProfilePolicy::HAS_BUTTONS)
+	{
+		updateVirtualButtons(controller, id, axis, newValue);
+	}
+}
+
+// Also turns -0.0 into 0, so flipped Y at rest doesn't read as changed or negative.
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+float BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::clampStickValue(const float value)
+{
+	if (value >= 1.0f)
+	{
+		return 1.0f;
+	}
+	else if (value <= -1.0f)
+	{
+		return -1.0f;
+	}
+	else if (value == 0)
+	{
+		return 0;
+	}
+
+	return value;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::processSticks()
+{
+	stickX.clear();
+	stickY.clear();
+	stickDeadzone.clear();
+	stickOwner.clear();
+
+	// Gather both sticks of each controller. Left stick at even index, right stick at odd index.
+	for (auto id : pendingStickControllers)
+	{
+		Controller* controller = findController(id);
+		if (controller == nullptr)
+		{
+			// Removed
+			continue;
+		}
+
+		controller->stickPending = false;
+
+		for (int stick = 0; stick < 2; stick++)
+		{
+			stickX.push_back(controller->getNormalizedStickValue(static_cast<IO::XBOX_360::AXIS>(stick * 2)));
+			stickY.push_back(controller->getNormalizedStickValue(static_cast<IO::XBOX_360::AXIS>(stick * 2 + 1)));
+			stickDeadzone.push_back(controller->getStickDeadzone(stick));
+			stickOwner.push_back(controller);
+		}
+	}
+
+	pendingStickControllers.clear();
+
+	const bool scaled = (stickDeadzoneMode == IO::XBOX_360::DEADZONE::SCALED_RADIAL);
+	StickProcessor::process(stickX.data(), stickY.data(), stickDeadzone.data(), static_cast<int>(stickX.size()), scaled, outerDeadzone, antiDeadzone);
+
+	// Write back. Only axises that changed are dispatched.
+	for (size_t i = 0; i < stickOwner.size(); i++)
+	{
+		Controller* controller = stickOwner[i];
+		const int stick = static_cast<int>(i % 2);
+
+		const IO::XBOX_360::AXIS axisX = static_cast<IO::XBOX_360::AXIS>(stick * 2);
+		const IO::XBOX_360::AXIS axisY = static_cast<IO::XBOX_360::AXIS>(stick * 2 + 1);
+
+		// Y is flipped. Up is positive.
+		const float newX = clampStickValue(stickX[i]);
+		const float newY = clampStickValue(-stickY[i]);
+
+		if (controller->axisValueMap[axisX] != newX)
+		{
+			applyAxisValue(controller, controller->id, axisX, newX);
+		}
+
+		if (controller->axisValueMap[axisY] != newY)
+		{
+			applyAxisValue(controller, controller->id, axisY, newY);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setStickDeadzoneMode(const IO::XBOX_360::DEADZONE mode)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	const bool changed = (stickDeadzoneMode != mode);
+	stickDeadzoneMode = mode;
+
+	if (!changed || mode == IO::XBOX_360::DEADZONE::AXIAL)
+	{
+		return;
+	}
+
+	// Held sticks were processed by old mode
+	for (auto& entry : controllers)
+	{
+		Controller* controller = entry.second;
+		if (controller != nullptr && controller->joystick == nullptr && !controller->stickPending)
+		{
+			controller->stickPending = true;
+			pendingStickControllers.push_back(entry.first);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const IO::XBOX_360::DEADZONE BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getStickDeadzoneMode()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return stickDeadzoneMode;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setOuterDeadzone(float value)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (value <= 0)
+	{
+		value = 1.0f;
+	}
+
+	if (value > 1.0f)
+	{
+		value = 1.0f;
+	}
+
+	outerDeadzone = value;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setAntiDeadzone(float value)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (value < 0)
+	{
+		value = 0;
+	}
+
+	if (value >= 1.0f)
+	{
+		value = 0.99f;
+	}
+
+	antiDeadzone = value;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Sint16 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getMinAxisValue(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->AXIS_MIN;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setMinAxisValue(ControllerID id, Sint16 value)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		controller->AXIS_MIN = value;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Sint16 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getMaxAxisValue(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->AXIS_MAX;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setMaxAxisValue(ControllerID id, Sint16 value)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		controller->AXIS_MAX = value;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::suspendWaitGroup(InputWaitGroup* group)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (group == nullptr || group->owner != nullptr)
+	{
+		// Invalid or already waiting
+		return;
+	}
+
+	group->owner = this;
+	group->fired = false;
+	group->firedIndex = -1;
+	group->firedID = ANY_CONTROLLER;
+	group->firedValue = 0;
+	group->readyNext = nullptr;
+
+	for (int i = 0; i < group->waiterCount; i++)
+	{
+		InputWaiter* waiter = &group->waiters[i];
+		waiter->group = group;
+		waiter->prev = nullptr;
+		waiter->next = nullptr;
+		waiter->linked = false;
+
+		InputWaiter** head = nullptr;
+		if (waiter->isAxis)
+		{
+			if (waiter->input >= 0 && waiter->input < IO::XBOX_360::AXIS_COUNT)
+			{
+				head = &axisWaitList[waiter->input];
+			}
+		}
+		else
+		{
+			if (waiter->input >= 0 && waiter->input < IO::XBOX_360::BUTTON_COUNT)
+			{
+				head = &buttonWaitList[waiter->input];
+			}
+		}
+
+		if (head == nullptr)
+		{
+			// Unknown input. Never fires.
+			continue;
+		}
+
+		// Push front
+		waiter->next = *head;
+		if (*head != nullptr)
+		{
+			(*head)->prev = waiter;
+		}
+		*head = waiter;
+		waiter->linked = true;
+	}
+
+	group->timerPrev = nullptr;
+	group->timerNext = nullptr;
+
+	if (group->hasDeadline)
+	{
+		if (timedWaitList == nullptr || static_cast<Sint32>(group->deadline - nextWaitDeadline) < 0)
+		{
+			nextWaitDeadline = group->deadline;
+		}
+
+		group->timerNext = timedWaitList;
+		if (timedWaitList != nullptr)
+		{
+			timedWaitList->timerPrev = group;
+		}
+		timedWaitList = group;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::cancelWaitGroup(InputWaitGroup* group)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (group == nullptr || group->owner != this)
+	{
+		return;
+	}
+
+	unlinkWaitGroup(group);
+
+	// Remove from ready list in case it fired but wasn't resumed yet
+	InputWaitGroup** link = &readyWaitList;
+	while (*link != nullptr)
+	{
+		if (*link == group)
+		{
+			*link = group->readyNext;
+			break;
+		}
+
+		link = &((*link)->readyNext);
+	}
+
+	group->readyNext = nullptr;
+	group->owner = nullptr;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::unlinkWaitGroup(InputWaitGroup* group)
+{
+	for (int i = 0; i < group->waiterCount; i++)
+	{
+		InputWaiter* waiter = &group->waiters[i];
+		if (!waiter->linked)
+		{
+			continue;
+		}
+
+		InputWaiter** head = waiter->isAxis ? &axisWaitList[waiter->input] : &buttonWaitList[waiter->input];
+
+		if (waiter->prev != nullptr)
+		{
+			waiter->prev->next = waiter->next;
+		}
+		else
+		{
+			*head = waiter->next;
+		}
+
+		if (waiter->next != nullptr)
+		{
+			waiter->next->prev = waiter->prev;
+		}
+
+		waiter->prev = nullptr;
+		waiter->next = nullptr;
+		waiter->linked = false;
+	}
+
+	if (group->hasDeadline)
+	{
+		if (group->timerPrev != nullptr)
+		{
+			group->timerPrev->timerNext = group->timerNext;
+		}
+		else if (timedWaitList == group)
+		{
+			timedWaitList = group->timerNext;
+		}
+
+		if (group->timerNext != nullptr)
+		{
+			group->timerNext->timerPrev = group->timerPrev;
+		}
+
+		group->timerPrev = nullptr;
+		group->timerNext = nullptr;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::resumeButtonWaiters(ControllerID id, IO::XBOX_360::BUTTON button)
+{
+	const int index = static_cast<int>(button);
+	if (index < 0 || index >= IO::XBOX_360::BUTTON_COUNT || buttonWaitList[index] == nullptr)
+	{
+		return;
+	}
+
+	// Collect first. Unlinking while iterating can remove next waiter from this list.
+	InputWaitGroup* fired = nullptr;
+	for (InputWaiter* waiter = buttonWaitList[index]; waiter != nullptr; waiter = waiter->next)
+	{
+		InputWaitGroup* group = waiter->group;
+		if (group->fired || (waiter->id != ANY_CONTROLLER && waiter->id != id))
+		{
+			continue;
+		}
+
+		group->fired = true;
+		group->firedIndex = static_cast<int>(waiter - group->waiters);
+		group->firedID = id;
+		group->firedValue = 1.0f;
+		group->readyNext = fired;
+		fired = group;
+	}
+
+	if (fired == nullptr)
+	{
+		return;
+	}
+
+	// Unlink and move to ready list
+	while (fired != nullptr)
+	{
+		InputWaitGroup* group = fired;
+		fired = group->readyNext;
+
+		unlinkWaitGroup(group);
+		group->readyNext = readyWaitList;
+		readyWaitList = group;
+	}
+
+	resumeReadyWaiters();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::resumeAxisWaiters(ControllerID id, IO::XBOX_360::AXIS axis, const float value)
+{
+	const int index = static_cast<int>(axis);
+	if (index < 0 || index >= IO::XBOX_360::AXIS_COUNT || axisWaitList[index] == nullptr)
+	{
+		return;
+	}
+
+	InputWaitGroup* fired = nullptr;
+	for (InputWaiter* waiter = axisWaitList[index]; waiter != nullptr; waiter = waiter->next)
+	{
+		InputWaitGroup* group = waiter->group;
+		if (group->fired || (waiter->id != ANY_CONTROLLER && waiter->id != id))
+		{
+			continue;
+		}
+
+		const bool beyond = (waiter->threshold >= 0) ? (value >= waiter->threshold) : (value <= waiter->threshold);
+		if (!beyond)
+		{
+			continue;
+		}
+
+		group->fired = true;
+		group->firedIndex = static_cast<int>(waiter - group->waiters);
+		group->firedID = id;
+		group->firedValue = value;
+		group->readyNext = fired;
+		fired = group;
+	}
+
+	if (fired == nullptr)
+	{
+		return;
+	}
+
+	while (fired != nullptr)
+	{
+		InputWaitGroup* group = fired;
+		fired = group->readyNext;
+
+		unlinkWaitGroup(group);
+		group->readyNext = readyWaitList;
+		readyWaitList = group;
+	}
+
+	resumeReadyWaiters();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::resumeTimedOutWaiters()
+{
+	const Uint32 now = SDL_GetTicks();
+	if (static_cast<Sint32>(now - nextWaitDeadline) < 0)
+	{
+		// Nothing timed out yet
+		return;
+	}
+
+	// Move timed out groups to ready list and find next deadline among rest
+	InputWaitGroup* group = timedWaitList;
+	bool hasNext = false;
+	while (group != nullptr)
+	{
+		InputWaitGroup* next = group->timerNext;
+
+		if (static_cast<Sint32>(now - group->deadline) >= 0)
+		{
+			group->fired = true;
+			group->firedIndex = -1;
+			group->firedID = ANY_CONTROLLER;
+			group->firedValue = 0;
+
+			unlinkWaitGroup(group);
+			group->readyNext = readyWaitList;
+			readyWaitList = group;
+		}
+		else if (!hasNext || static_cast<Sint32>(group->deadline - nextWaitDeadline) < 0)
+		{
+			nextWaitDeadline = group->deadline;
+			hasNext = true;
+		}
+
+		group = next;
+	}
+
+	resumeReadyWaiters();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::resumeReadyWaiters()
+{
+	// Pop one by one. Resumed coroutine can wait again or cancel other group.
+	while (readyWaitList != nullptr)
+	{
+		InputWaitGroup* group = readyWaitList;
+		readyWaitList = group->readyNext;
+
+		group->readyNext = nullptr;
+		group->owner = nullptr;
+
+		if (group->resume != nullptr)
+		{
+			group->resume(group->handle);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getWaitDeadlineTimeout()
+{
+	if (timedWaitList == nullptr)
+	{
+		return -1;
+	}
+
+	const Sint32 remaining = static_cast<Sint32>(nextWaitDeadline - SDL_GetTicks());
+	return remaining > 0 ? remaining : 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+Controller* BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::findController(ControllerID id)
+{
+	auto find_it = this->controllers.find(id);
+	if (find_it != this->controllers.end())
+	{
+		return (find_it->second);
+	}
+	else
+	{
+		return nullptr;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::recordChange(Controller* controller, const IO::INPUT_TYPE type, const int input, const float oldValue, const float newValue)
+{
+	if (!controller->dirty)
+	{
+		controller->dirty = true;
+		dirtyControllers.push_back(controller->id);
+	}
+
+	switch (type)
+	{
+	case IO::INPUT_TYPE::BUTTON:
+		controller->dirtyButtons |= (static_cast<Uint64>(1) << input);
+		break;
+	case IO::INPUT_TYPE::AXIS:
+		controller->dirtyAxes |= (1u << input);
+		break;
+	case IO::INPUT_TYPE::JOYSTICK_BUTTON:
+		controller->joystickDirtyButtonBits[input >> 5] |= (1u << (input & 31));
+		break;
+	case IO::INPUT_TYPE::JOYSTICK_AXIS:
+		if (input < 64)
+		{
+			controller->dirtyJoystickAxes |= (static_cast<Uint64>(1) << input);
+		}
+		break;
+	default:
+		break;
+	}
+
+	InputChange change;
+	change.id = controller->id;
+	change.type = type;
+	change.input = input;
+	change.oldValue = oldValue;
+	change.newValue = newValue;
+	changeJournal.push_back(change);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const std::vector<InputChange>& BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getChanges()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return changeJournal;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const std::vector<ControllerID>& BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getDirtyControllers()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return dirtyControllers;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint64 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getDirtyButtons(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->dirtyButtons;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint32 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getDirtyAxes(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->dirtyAxes;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isJoystickButtonDirty(ControllerID id, const int button)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (button >= 0 && button < static_cast<int>(controller->joystickDirtyButtonBits.size()) * 32)
+		{
+			return (controller->joystickDirtyButtonBits[button >> 5] & (1u << (button & 31))) != 0;
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint64 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getDirtyJoystickAxes(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->dirtyJoystickAxes;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::enableSharedStateExport(const std::string& name)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	disableSharedStateExport();
+
+	SharedStateWriter* writer = new SharedStateWriter();
+	if (!writer->open(name))
+	{
+		delete writer;
+		return false;
+	}
+
+	sharedStateWriter = writer;
+
+	// Write whole table once. After this, only dirty controllers are written.
+	sharedStateWriter->beginWrite();
+	for (auto& entry : this->controllers)
+	{
+		if (entry.second != nullptr)
+		{
+			exportControllerState(entry.first);
+		}
+	}
+	sharedStateWriter->endWrite();
+
+	sharedStatePublished = changeJournal.size();
+
+	return true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::disableSharedStateExport()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (sharedStateWriter != nullptr)
+	{
+		delete sharedStateWriter;
+		sharedStateWriter = nullptr;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isSharedStateExportEnabled()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return sharedStateWriter != nullptr;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::publishSharedState()
+{
+	sharedStateWriter->beginWrite();
+	for (auto id : dirtyControllers)
+	{
+		exportControllerState(id);
+	}
+	sharedStateWriter->endWrite();
+
+	sharedStatePublished = changeJournal.size();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::exportControllerState(const ControllerID id)
+{
+	Controller* controller = findController(id);
+
+	SharedControllerState* slot = sharedStateWriter->getSlot(id, controller != nullptr);
+	if (slot == nullptr)
+	{
+		// Table is full, or disconnected controller that was never exported
+		return;
+	}
+
+	if (controller == nullptr)
+	{
+		// Keep last state so readers can still see it
+		slot->flags &= ~SHARED_STATE_CONNECTED;
+	}
+	else if (controller->joystick == nullptr)
+	{
+		slot->flags = SHARED_STATE_CONNECTED | SHARED_STATE_GAME_CONTROLLER;
+		slot->buttons = 0;
+
+		for (auto& button : controller->buttonStateMap)
+		{
+			if (button.second)
+			{
+				slot->buttons |= (static_cast<Uint64>(1) << static_cast<int>(button.first));
+			}
+		}
+
+		for (int i = 0; i < SHARED_STATE_AXIS_COUNT; i++)
+		{
+			slot->axes[i] = 0;
+		}
+
+		for (auto& axis : controller->axisValueMap)
+		{
+			slot->axes[static_cast<int>(axis.first)] = axis.second;
+		}
+	}
+	else
+	{
+		slot->flags = SHARED_STATE_CONNECTED;
+		slot->buttons = 0;
+
+		// Buttons followed by hat directions, first 64 bits
+		for (size_t i = 0; i < controller->joystickButtonBits.size() && i < 2; i++)
+		{
+			slot->buttons |= static_cast<Uint64>(controller->joystickButtonBits[i]) << (i * 32);
+		}
+
+		for (int i = 0; i < SHARED_STATE_AXIS_COUNT; i++)
+		{
+			slot->axes[i] = (i < static_cast<int>(controller->joystickAxisValues.size())) ? controller->joystickAxisValues[i] : 0;
+		}
+	}
+
+	slot->sequence = sharedStateWriter->getSequence();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::countIgnoredEvent(Controller* controller)
+{
+	metrics.total.ignoredEvents++;
+
+	if (controller != nullptr)
+	{
+		controller->metrics.ignoredEvents++;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::recordCallbackTime(Controller* controller, const IO::CALLBACK_TYPE type, const Uint64 start)
+{
+	const Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+	const int index = static_cast<int>(type);
+
+	metrics.total.callbackCalls[index]++;
+	metrics.total.callbackTime[index] += elapsed;
+
+	if (controller != nullptr)
+	{
+		controller->metrics.callbackCalls[index]++;
+		controller->metrics.callbackTime[index] += elapsed;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint64 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::toMicroseconds(const Uint64 counter)
+{
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	if (frequency == 0)
+	{
+		return 0;
+	}
+
+	return (counter / frequency) * 1000000 + ((counter % frequency) * 1000000) / frequency;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::convertMetricsTime(ControllerMetrics& metrics)
+{
+	for (int i = 0; i < IO::CALLBACK_TYPE_COUNT; i++)
+	{
+		metrics.callbackTime[i] = toMicroseconds(metrics.callbackTime[i]);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const InputMetrics BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getMetrics()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	InputMetrics snapshot = metrics;
+
+	for (auto& entry : controllers)
+	{
+		if (entry.second != nullptr)
+		{
+			ControllerMetrics controllerMetrics = entry.second->metrics;
+			convertMetricsTime(controllerMetrics);
+			snapshot.controllers[entry.first] = controllerMetrics;
+		}
+	}
+
+	convertMetricsTime(snapshot.total);
+	snapshot.updateTime = toMicroseconds(snapshot.updateTime);
+	snapshot.lastUpdateTime = toMicroseconds(snapshot.lastUpdateTime);
+	snapshot.maxUpdateTime = toMicroseconds(snapshot.maxUpdateTime);
+
+	return snapshot;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::dumpControllerMetrics(std::ostream& out, const ControllerMetrics& metrics, const std::string& prefix, const bool json)
+{
+	const char* names[] = { "buttonDownEvents", "buttonUpEvents", "axisEvents", "ignoredEvents", "hapticWrites" };
+	const Uint64 values[] = { metrics.buttonDownEvents, metrics.buttonUpEvents, metrics.axisEvents, metrics.ignoredEvents, metrics.hapticWrites };
+
+	for (int i = 0; i < 5; i++)
+	{
+		if (json)
+		{
+			out << (i == 0 ? "" : ",") << "\"" << names[i] << "\":" << values[i];
+		}
+		else
+		{
+			out << prefix << names[i] << " " << values[i] << "\n";
+		}
+	}
+
+	// Indexed by IO::CALLBACK_TYPE
+	const char* callbackNames[] = { "controllerConnected", "controllerDisconnected", "buttonPressed", "buttonReleased", "axisMoved", "joystickButtonPressed", "joystickButtonReleased", "joystickAxisMoved" };
+	const char* groupNames[] = { "callbackCalls", "callbackTime" };
+	const Uint64* groupValues[] = { metrics.callbackCalls, metrics.callbackTime };
+
+	for (int group = 0; group < 2; group++)
+	{
+		if (json)
+		{
+			out << ",\"" << groupNames[group] << "\":{";
+		}
+
+		for (int i = 0; i < IO::CALLBACK_TYPE_COUNT; i++)
+		{
+			if (json)
+			{
+				out << (i == 0 ? "" : ",") << "\"" << callbackNames[i] << "\":" << groupValues[group][i];
+			}
+			else
+			{
+				out << prefix << groupNames[group] << "." << callbackNames[i] << " " << groupValues[group][i] << "\n";
+			}
+		}
+
+		if (json)
+		{
+			out << "}";
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const std::string BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::dumpMetrics(const bool json)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	const InputMetrics snapshot = getMetrics();
+
+	const char* names[] = { "droppedEvents", "unknownControllerEvents", "connections", "disconnections", "updates", "updateTime", "lastUpdateTime", "maxUpdateTime", "queueDepth", "maxQueueDepth", "lastUpdateTicks", "lastEventTicks" };
+	const Uint64 values[] = { snapshot.droppedEvents, snapshot.unknownControllerEvents, snapshot.connections, snapshot.disconnections, snapshot.updates, snapshot.updateTime, snapshot.lastUpdateTime, snapshot.maxUpdateTime, snapshot.queueDepth, snapshot.maxQueueDepth, snapshot.lastUpdateTicks, snapshot.lastEventTicks };
+
+	std::ostringstream out;
+
+	if (json)
+	{
+		out << "{";
+		for (int i = 0; i < 12; i++)
+		{
+			out << "\"" << names[i] << "\":" << values[i] << ",";
+		}
+
+		out << "\"total\":{";
+		dumpControllerMetrics(out, snapshot.total, "", true);
+		out << "},\"controllers\":{";
+
+		bool first = true;
+		for (auto& entry : snapshot.controllers)
+		{
+			out << (first ? "" : ",") << "\"" << entry.first << "\":{";
+			dumpControllerMetrics(out, entry.second, "", true);
+			out << "}";
+			first = false;
+		}
+
+		out << "}}";
+	}
+	else
+	{
+		for (int i = 0; i < 12; i++)
+		{
+			out << names[i] << " " << values[i] << "\n";
+		}
+
+		dumpControllerMetrics(out, snapshot.total, "total.", false);
+
+		for (auto& entry : snapshot.controllers)
+		{
+			dumpControllerMetrics(out, entry.second, "controller." + std::to_string(entry.first) + ".", false);
+		}
+	}
+
+	return out.str();
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::resetMetrics()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	metrics.total = ControllerMetrics();
+	metrics.droppedEvents = 0;
+	metrics.unknownControllerEvents = 0;
+	metrics.connections = 0;
+	metrics.disconnections = 0;
+	metrics.updates = 0;
+	metrics.updateTime = 0;
+	metrics.lastUpdateTime = 0;
+	metrics.maxUpdateTime = 0;
+	metrics.queueDepth = 0;
+	metrics.maxQueueDepth = 0;
+	metrics.lastUpdateTicks = 0;
+	metrics.lastEventTicks = 0;
+	metrics.controllers.clear();
+
+	for (auto& entry : controllers)
+	{
+		if (entry.second != nullptr)
+		{
+			SDL_zero(entry.second->metrics);
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setVirtualButtonThreshold(ControllerID id, IO::XBOX_360::BUTTON button, float pressThreshold, float releaseThreshold)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	const int index = static_cast<int>(button) - IO::XBOX_360::VIRTUAL_BUTTON_BEGIN;
+	if (index < 0 || index >= IO::XBOX_360::VIRTUAL_BUTTON_COUNT)
+	{
+		// Not a virtual button
+		return;
+	}
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (releaseThreshold > pressThreshold)
+		{
+			releaseThreshold = pressThreshold;
+		}
+
+		controller->virtualButtons[index].pressThreshold = pressThreshold;
+		controller->virtualButtons[index].releaseThreshold = releaseThreshold;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setAutoCalibration(const bool enabled)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	autoCalibration = enabled;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isAutoCalibrationEnabled()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return autoCalibration;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::startCalibration(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		beginCalibration(controller);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::beginCalibration(Controller* controller)
+{
+	const bool tracked = controller->calibrating;
+	controller->startCalibration();
+
+	if (!tracked)
+	{
+		calibratingControllers.push_back(controller->id);
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::processCalibration()
+{
+	for (size_t i = 0; i < calibratingControllers.size();)
+	{
+		Controller* controller = findController(calibratingControllers[i]);
+
+		if (controller != nullptr && controller->calibrating && controller->sampleCalibration())
+		{
+			storeCalibrationProfile(controller);
+		}
+
+		// Removed, reset or finished
+		if (controller == nullptr || !controller->calibrating)
+		{
+			calibratingControllers[i] = calibratingControllers.back();
+			calibratingControllers.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isCalibrating(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->calibrating;
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::resetCalibration(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		controller->resetCalibration();
+
+		auto find_it = calibrationProfiles.find(std::string(reinterpret_cast<const char*>(controller->guid.data), sizeof(controller->guid.data)));
+		if (find_it != calibrationProfiles.end())
+		{
+			calibrationProfiles.erase(find_it);
+			calibrationProfilesDirty = true;
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Sint16 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getAxisCenter(ControllerID id, IO::XBOX_360::AXIS axis)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr && controller->hasAxis(axis))
+	{
+		return controller->axisCalibration[static_cast<int>(axis)].center;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Sint16 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getAxisDeadzone(ControllerID id, IO::XBOX_360::AXIS axis)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr && controller->hasAxis(axis))
+	{
+		return controller->axisCalibration[static_cast<int>(axis)].deadzone;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::applyCalibrationProfile(Controller* controller)
+{
+	auto find_it = calibrationProfiles.find(std::string(reinterpret_cast<const char*>(controller->guid.data), sizeof(controller->guid.data)));
+	if (find_it == calibrationProfiles.end())
+	{
+		return false;
+	}
+
+	const CalibrationProfile& profile = find_it->second;
+	// Only stick axises are calibrated
+	for (int i = 0; i < CALIBRATION_AXIS_COUNT; i++)
+	{
+		if (profile.calibratedMask & (1 << i))
+		{
+			Controller::AxisCalibration& calibration = controller->axisCalibration[i];
+			calibration.calibrated = true;
+			calibration.center = profile.center[i];
+			calibration.deadzone = profile.deadzone[i];
+		}
+	}
+
+	return true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::storeCalibrationProfile(Controller* controller)
+{
+	CalibrationProfile profile;
+	profile.calibratedMask = 0;
+
+	for (int i = 0; i < IO::XBOX_360::AXIS_COUNT; i++)
+	{
+		const Controller::AxisCalibration& calibration = controller->axisCalibration[i];
+		if (calibration.calibrated)
+		{
+			profile.calibratedMask |= (1 << i);
+		}
+
+		profile.center[i] = calibration.center;
+		profile.deadzone[i] = calibration.deadzone;
+	}
+
+	calibrationProfiles[std::string(reinterpret_cast<const char*>(controller->guid.data), sizeof(controller->guid.data))] = profile;
+	calibrationProfilesDirty = true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::writeUint16(std::ostream& out, const Uint16 value)
+{
+	const char bytes[2] = { static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF) };
+	out.write(bytes, 2);
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint16 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::readUint16(std::istream& in)
+{
+	unsigned char bytes[2] = { 0, 0 };
+	in.read(reinterpret_cast<char*>(bytes), 2);
+	return static_cast<Uint16>(bytes[0] | (bytes[1] << 8));
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::loadCalibrationProfiles(const std::string& path)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	calibrationProfilePath = path;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	char magic[4];
+	file.read(magic, 4);
+	if (!file || std::memcmp(magic, CALIBRATION_FILE_MAGIC, 4) != 0 || readUint16(file) != CALIBRATION_FILE_VERSION)
+	{
+		LogPolicy::write("Invalid calibration profile file: ", path.c_str());
+		return false;
+	}
+
+	// Parse whole file first. Truncated file must not leave partial profiles behind.
+	std::unordered_map<std::string, CalibrationProfile> profiles;
+
+	const Uint16 count = readUint16(file);
+	for (Uint16 i = 0; i < count; i++)
+	{
+		char guid[16];
+		file.read(guid, 16);
+
+		char flags[2];
+		file.read(flags, 2);
+
+		CalibrationProfile profile;
+		profile.calibratedMask = static_cast<Uint8>(flags[0]);
+
+		for (int j = 0; j < IO::XBOX_360::AXIS_COUNT; j++)
+		{
+			profile.center[j] = static_cast<Sint16>(readUint16(file));
+		}
+
+		for (int j = 0; j < IO::XBOX_360::AXIS_COUNT; j++)
+		{
+			profile.deadzone[j] = static_cast<Sint16>(readUint16(file));
+		}
+
+		if (!file)
+		{
+			LogPolicy::write("Truncated calibration profile file: ", path.c_str());
+			return false;
+		}
+
+		profiles[std::string(guid, 16)] = profile;
+	}
+
+	for (auto& entry : profiles)
+	{
+		calibrationProfiles[entry.first] = entry.second;
+	}
+
+	// Apply to controllers that are already connected
+	for (auto& entry : controllers)
+	{
+		if (entry.second != nullptr && !entry.second->calibrating)
+		{
+			applyCalibrationProfile(entry.second);
+		}
+	}
+
+	return true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::saveCalibrationProfiles()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (calibrationProfilePath.empty())
+	{
+		return false;
+	}
+
+	std::ofstream file(calibrationProfilePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file.write(CALIBRATION_FILE_MAGIC, 4);
+	writeUint16(file, CALIBRATION_FILE_VERSION);
+	writeUint16(file, static_cast<Uint16>(calibrationProfiles.size()));
+
+	for (auto& entry : calibrationProfiles)
+	{
+		const CalibrationProfile& profile = entry.second;
+
+		file.write(entry.first.data(), 16);
+
+		const char flags[2] = { static_cast<char>(profile.calibratedMask), 0 };
+		file.write(flags, 2);
+
+		for (int j = 0; j < IO::XBOX_360::AXIS_COUNT; j++)
+		{
+			writeUint16(file, static_cast<Uint16>(profile.center[j]));
+		}
+
+		for (int j = 0; j < IO::XBOX_360::AXIS_COUNT; j++)
+		{
+			writeUint16(file, static_cast<Uint16>(profile.deadzone[j]));
+		}
+	}
+
+	if (!file)
+	{
+		return false;
+	}
+
+	calibrationProfilesDirty = false;
+	return true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::hasUnsavedCalibrationProfiles()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return calibrationProfilesDirty;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const float BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getHapticModifier(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->hapticModifier;
+	}
+
+	return 0.0f;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::setHapticModifier(ControllerID id, float modifier)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (modifier < 0)
+		{
+			modifier = 0;
+		}
+
+		if (modifier > 2.0f)
+		{
+			modifier = 2.0f;
+		}
+
+		controller->hapticModifier = modifier;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::playRumble(ControllerID id, float strength, Uint32 length)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (HapticPolicy::ENABLED && controller != nullptr)
+	{
+		if (strength < 0)
+		{
+			strength = 0;
+		}
+
+		if (length < 0)
+		{
+			length = 0;
+		}
+		HapticPolicy::rumble(controller->haptic, strength * controller->hapticModifier, length);
+		controller->metrics.hapticWrites++;
+		metrics.total.hapticWrites++;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isButtonPressed(ControllerID id, IO::XBOX_360::BUTTON button)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (controller->hasButton(button))
+		{
+			return controller->buttonStateMap[button] == true;
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isButtonReleased(ControllerID id, IO::XBOX_360::BUTTON button)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (controller->hasButton(button))
+		{
+			return controller->buttonStateMap[button] == false;
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isAxisMoved(ControllerID id, IO::XBOX_360::AXIS axis)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (controller->hasAxis(axis))
+		{
+			return controller->axisValueMap[axis] != 0;
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::enableFastPath(const Uint32 pumpInterval)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (!fastPathEnabled && active)
+	{
+		SDL_AddEventWatch(&BasicControllerManager::fastPathWatch, this);
+		fastPathEnabled = true;
+
+#if defined(CONTROLLER_MANAGER_FAST_PATH_PUMP)
+		if (pumpInterval > 0)
+		{
+			fastPathPumpInterval = pumpInterval;
+			fastPathPumpRunning.store(true, std::memory_order_release);
+			fastPathPumpThread = SDL_CreateThread(&BasicControllerManager::fastPathPump, "FastPathPump", this);
+			if (fastPathPumpThread == nullptr)
+			{
+				// Watch still works, only at update rate
+				fastPathPumpRunning.store(false, std::memory_order_release);
+				LogPolicy::write("Failed to create fast path pump thread. SDL Error : ", SDL_GetError());
+			}
+		}
+#else
+		// Joysticks can only be updated on the thread that set them up. Watch runs at update rate.
+		(void)pumpInterval;
+#endif
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::disableFastPath()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (fastPathEnabled)
+	{
+		if (fastPathPumpThread != nullptr)
+		{
+			fastPathPumpRunning.store(false, std::memory_order_release);
+			SDL_WaitThread(fastPathPumpThread, nullptr);
+			fastPathPumpThread = nullptr;
+		}
+
+		SDL_DelEventWatch(&BasicControllerManager::fastPathWatch, this);
+		fastPathEnabled = false;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isFastPathEnabled()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return fastPathEnabled;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isFastPathPumpRunning()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	return fastPathPumpThread != nullptr;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::addFastPathListener(FastPathListener listener, void* userData)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	const int count = fastPathListenerCount.load(std::memory_order_relaxed);
+	if (listener == nullptr || count >= MAX_FAST_PATH_LISTENER)
+	{
+		return false;
+	}
+
+	// Write entry first, then publish it by count
+	fastPathListeners[count].listener = listener;
+	fastPathListeners[count].userData = userData;
+	fastPathListenerCount.store(count + 1, std::memory_order_release);
+
+	return true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::clearFastPathListeners()
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	if (fastPathEnabled)
+	{
+		// Watch thread might be calling them
+		return false;
+	}
+
+	fastPathListenerCount.store(0, std::memory_order_release);
+	return true;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isButtonPressedFast(ControllerID id, IO::XBOX_360::BUTTON button)
+{
+	const int index = static_cast<int>(button);
+	if (index < 0 || index >= 64)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < MAX_FAST_PATH_CONTROLLER; i++)
+	{
+		if (fastPathSlots[i].id.load(std::memory_order_acquire) == id)
+		{
+			return (fastPathSlots[i].buttons.load(std::memory_order_acquire) & (static_cast<Uint64>(1) << index)) != 0;
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint64 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getFastPathTimestamp(ControllerID id)
+{
+	for (int i = 0; i < MAX_FAST_PATH_CONTROLLER; i++)
+	{
+		if (fastPathSlots[i].id.load(std::memory_order_acquire) == id)
+		{
+			return fastPathSlots[i].timestamp.load(std::memory_order_acquire);
+		}
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::fastPathWatch(void* userData, SDL_Event* event)
+{
+	if (event->type != SDL_CONTROLLERBUTTONDOWN && event->type != SDL_CONTROLLERBUTTONUP)
+	{
+		return 0;
+	}
+
+	// Take timestamp first
+	const Uint64 timestamp = SDL_GetPerformanceCounter();
+
+	BasicControllerManager* manager = static_cast<BasicControllerManager*>(userData);
+	const SDL_ControllerButtonEvent& buttonEvent = event->cbutton;
+
+	if (buttonEvent.button >= IO::XBOX_360::VIRTUAL_BUTTON_BEGIN)
+	{
+		return 0;
+	}
+
+	const ControllerID id = static_cast<ControllerID>(buttonEvent.which);
+	const bool pressed = (buttonEvent.state == SDL_PRESSED);
+	const Uint64 bit = static_cast<Uint64>(1) << buttonEvent.button;
+
+	for (int i = 0; i < MAX_FAST_PATH_CONTROLLER; i++)
+	{
+		FastPathSlot& slot = manager->fastPathSlots[i];
+		if (slot.id.load(std::memory_order_acquire) == id)
+		{
+			if (pressed)
+			{
+				slot.buttons.fetch_or(bit, std::memory_order_acq_rel);
+			}
+			else
+			{
+				slot.buttons.fetch_and(~bit, std::memory_order_acq_rel);
+			}
+
+			slot.timestamp.store(timestamp, std::memory_order_release);
+			break;
+		}
+	}
+
+	const IO::XBOX_360::BUTTON button = static_cast<IO::XBOX_360::BUTTON>(buttonEvent.button);
+	const int count = manager->fastPathListenerCount.load(std::memory_order_acquire);
+	for (int i = 0; i < count; i++)
+	{
+		const FastPathListenerEntry& entry = manager->fastPathListeners[i];
+		entry.listener(id, button, pressed, timestamp, entry.userData);
+	}
+
+	// Return value is ignored for event watch
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::fastPathPump(void* userData)
+{
+	BasicControllerManager* manager = static_cast<BasicControllerManager*>(userData);
+
+	// SDL_JoystickUpdate locks joysticks, so it's safe next to update() pumping on its own thread
+	// (on platforms of CONTROLLER_MANAGER_FAST_PATH_PUMP). Events it pushes go through fastPathWatch
+	// on this thread and are queued for update() as usual.
+	while (manager->fastPathPumpRunning.load(std::memory_order_acquire))
+	{
+		SDL_JoystickUpdate();
+		SDL_Delay(manager->fastPathPumpInterval);
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::assignFastPathSlot(ControllerID id)
+{
+	for (int i = 0; i < MAX_FAST_PATH_CONTROLLER; i++)
+	{
+		FastPathSlot& slot = fastPathSlots[i];
+		if (slot.id.load(std::memory_order_relaxed) == -1)
+		{
+			slot.buttons.store(0, std::memory_order_relaxed);
+			slot.timestamp.store(0, std::memory_order_relaxed);
+			slot.id.store(id, std::memory_order_release);
+			return;
+		}
+	}
+
+	// No empty slot. Controller isn't tracked by fast path but listeners are still called.
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+void BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::releaseFastPathSlot(ControllerID id)
+{
+	for (int i = 0; i < MAX_FAST_PATH_CONTROLLER; i++)
+	{
+		FastPathSlot& slot = fastPathSlots[i];
+		if (slot.id.load(std::memory_order_relaxed) == id)
+		{
+			slot.id.store(-1, std::memory_order_release);
+			return;
+		}
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::hasHaptic(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return (controller->haptic != nullptr);
+	}
+	else
+	{
+		return false;
+	}
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isGameController(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->joystick == nullptr;
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getButtonCount(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->buttonCount;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getAxisCount(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->axisCount;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getHatCount(ControllerID id)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		return controller->hatCount;
+	}
+
+	return 0;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const bool BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::isJoystickButtonPressed(ControllerID id, const int button)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (button >= 0 && button < static_cast<int>(controller->joystickButtonBits.size()) * 32)
+		{
+			return controller->getJoystickButton(button);
+		}
+	}
+
+	return false;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const float BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getJoystickAxisValue(ControllerID id, const int axis)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (axis >= 0 && axis < static_cast<int>(controller->joystickAxisValues.size()))
+		{
+			return controller->joystickAxisValues[axis];
+		}
+	}
+
+	return 0.0f;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const Uint8 BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getJoystickHat(ControllerID id, const int hat)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (hat >= 0 && hat < static_cast<int>(controller->joystickHatValues.size()))
+		{
+			return controller->joystickHatValues[hat];
+		}
+	}
+
+	return SDL_HAT_CENTERED;
+}
+
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+const int BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>::getJoystickHatButton(ControllerID id, const int hat, const int direction)
+{
+	typename ThreadingPolicy::Guard guard(mutex);
+
+	Controller* controller = findController(id);
+	if (controller != nullptr)
+	{
+		if (hat >= 0 && hat < controller->hatCount && direction >= 0 && direction < 4)
+		{
+			return controller->buttonCount + hat * 4 + direction;
+		}
+	}
+
+	return -1;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,214 @@
+#ifndef CONTROLLER_AWAIT_H
+#define CONTROLLER_AWAIT_H
+
+#include "ControllerManager.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+
+/**
+*	Coroutine awaitables for controller input. Requires C++20.
+*
+*	Instead of polling isButtonPressed every frame, scripted sequence can simply wait for input.
+*
+*	IO::InputTask tutorial()
+*	{
+*		co_await IO::nextPress(ANY_CONTROLLER, IO::XBOX_360::BUTTON::A);
+*		auto result = co_await IO::anyOf(IO::nextPress(id, IO::XBOX_360::BUTTON::B), IO::axisBeyond(id, IO::XBOX_360::AXIS::LT, 0.8f)).withTimeout(3000);
+*		if (result.timedOut()) { ... }
+*	}
+*
+*	Waiting coroutines are linked to manager's wait list of each button and axis and resumed
+*	directly from update() (or waitForInput()) when input fires. Timeouts are in milliseconds.
+*/
+namespace IO
+{
+	/**
+	*	Result of co_await.
+	*	index is index of condition that fired (in order given to anyOf), -1 if timed out.
+	*/
+	struct AwaitResult
+	{
+		int index;
+		ControllerID id;
+		float value;
+
+		const bool timedOut() const { return index < 0; }
+		explicit operator bool() const { return index >= 0; }
+	};
+
+	template<int N>
+	class InputAwaitable
+	{
+	private:
+		template<int M>
+		friend class InputAwaitable;
+
+		template<int... Ns>
+		friend InputAwaitable<(Ns + ...)> anyOf(const InputAwaitable<Ns>&... awaitables);
+
+		InputWaiter waiters[N];
+		InputWaitGroup group;
+
+		// Timeout in milliseconds. 0 means no timeout.
+		Uint32 timeout;
+
+		static void resumeHandle(void* handle)
+		{
+			std::coroutine_handle<>::from_address(handle).resume();
+		}
+
+		// Copy conditions of other awaitable starting from offset
+		template<int M>
+		void append(const InputAwaitable<M>& other, int& offset)
+		{
+			for (int i = 0; i < M; i++)
+			{
+				waiters[offset + i] = other.waiters[i];
+			}
+			offset += M;
+
+			if (other.timeout > 0 && (timeout == 0 || other.timeout < timeout))
+			{
+				timeout = other.timeout;
+			}
+		}
+	public:
+		InputAwaitable()
+			: waiters(),
+			group(),
+			timeout(0)
+		{
+		}
+
+		InputAwaitable(const InputAwaitable& other)
+			: group(),
+			timeout(other.timeout)
+		{
+			// Copy only conditions. Group is set up when awaited.
+			for (int i = 0; i < N; i++)
+			{
+				waiters[i] = other.waiters[i];
+			}
+		}
+
+		InputAwaitable& operator=(const InputAwaitable&) = delete;
+
+		~InputAwaitable()
+		{
+			// Coroutine destroyed while waiting
+			if (group.owner != nullptr)
+			{
+				group.owner->cancelWaitGroup(&group);
+			}
+		}
+
+		// Returns copy with timeout in milliseconds
+		InputAwaitable withTimeout(const Uint32 milliseconds) const
+		{
+			InputAwaitable result(*this);
+			result.timeout = milliseconds;
+			return result;
+		}
+
+		// Set condition. Used by nextPress and axisBeyond.
+		void setCondition(const int index, const ControllerID id, const bool isAxis, const int input, const float threshold)
+		{
+			InputWaiter& waiter = waiters[index];
+			waiter.prev = nullptr;
+			waiter.next = nullptr;
+			waiter.group = nullptr;
+			waiter.id = id;
+			waiter.isAxis = isAxis;
+			waiter.input = input;
+			waiter.threshold = threshold;
+			waiter.linked = false;
+		}
+
+		const bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			group.waiters = waiters;
+			group.waiterCount = N;
+			group.resume = &InputAwaitable::resumeHandle;
+			group.handle = handle.address();
+			group.owner = nullptr;
+			group.hasDeadline = (timeout > 0);
+			group.deadline = SDL_GetTicks() + timeout;
+
+			ControllerManager::getInstance()->suspendWaitGroup(&group);
+		}
+
+		AwaitResult await_resume() const noexcept
+		{
+			AwaitResult result;
+			result.index = group.firedIndex;
+			result.id = group.firedID;
+			result.value = group.firedValue;
+			return result;
+		}
+	};
+
+	/**
+	*	Waits next press of button.
+	*	@param id Controller id or ANY_CONTROLLER.
+	*	@param timeout Timeout in milliseconds. 0 to wait forever.
+	*/
+	inline InputAwaitable<1> nextPress(const ControllerID id, const IO::XBOX_360::BUTTON button, const Uint32 timeout = 0)
+	{
+		InputAwaitable<1> awaitable;
+		awaitable.setCondition(0, id, false, static_cast<int>(button), 0);
+		return timeout > 0 ? awaitable.withTimeout(timeout) : awaitable;
+	}
+
+	/**
+	*	Waits next axis movement beyond threshold.
+	*	Positive threshold waits value >= threshold, negative threshold waits value <= threshold.
+	*	@param id Controller id or ANY_CONTROLLER.
+	*	@param timeout Timeout in milliseconds. 0 to wait forever.
+	*/
+	inline InputAwaitable<1> axisBeyond(const ControllerID id, const IO::XBOX_360::AXIS axis, const float threshold, const Uint32 timeout = 0)
+	{
+		InputAwaitable<1> awaitable;
+		awaitable.setCondition(0, id, true, static_cast<int>(axis), threshold);
+		return timeout > 0 ? awaitable.withTimeout(timeout) : awaitable;
+	}
+
+	/**
+	*	Waits whichever fires first.
+	*	Conditions are flattened in given order. Shortest timeout among them is used.
+	*/
+	template<int... Ns>
+	InputAwaitable<(Ns + ...)> anyOf(const InputAwaitable<Ns>&... awaitables)
+	{
+		InputAwaitable<(Ns + ...)> result;
+		int offset = 0;
+		(result.append(awaitables, offset), ...);
+		return result;
+	}
+
+	/**
+	*	Fire and forget coroutine type for input scripts.
+	*	Starts immediately and frees itself when finished.
+	*/
+	struct InputTask
+	{
+		struct promise_type
+		{
+			InputTask get_return_object() { return InputTask(); }
+			std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+			std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+}
+
+#endif
+
+#endif
@@ -1,34 +1,38 @@
-#include "ControllerManager.h"
-#include <iostream>
-#include <string>
-
-using namespace std;
-
-ControllerManager* ControllerManager::instance = nullptr;
-
-std::function<void(ControllerID, IO::XBOX_360::BUTTON)> ControllerManager::onButtonPressed = nullptr;
-std::function<void(ControllerID, IO::XBOX_360::BUTTON)> ControllerManager::onButtonReleased = nullptr;
-std::function<void(ControllerID, IO::XBOX_360::AXIS, const float)> ControllerManager::onAxisMoved = nullptr;
-std::function<void(ControllerID)> ControllerManager::onControllerConnected = nullptr;
-std::function<void(ControllerID)> ControllerManager::onControllerDisconnected = nullptr;
+#include "BasicControllerManager.h"
+#include <cmath>
 
 Controller::Controller(SDL_GameController* controller, 
+	SDL_Joystick* joystick,
 	SDL_Haptic* haptic, 
 	const std::string& name, 
 	const ControllerID id, 
 	const int buttonCount,
-	const int axisCount) 
+	const int axisCount,
+	const int hatCount) 
 	: controller(controller),
+	joystick(joystick),
 	haptic(haptic),
 	name(name), 
 	id(id), 
 	buttonCount(buttonCount), 
 	axisCount(axisCount),
+	hatCount(hatCount),
 	hapticEnabled(false),
 	hapticModifier(1.0f),
-	AXIS_MAX(10000), 
-	AXIS_MIN(-10000)
+	AXIS_MAX(DEFAULT_AXIS_MAX), 
+	AXIS_MIN(DEFAULT_AXIS_MIN),
+	calibrating(false),
+	stickPending(false),
+	dirty(false),
+	dirtyButtons(0),
+	dirtyAxes(0),
+	dirtyJoystickAxes(0)
 {
+	SDL_zero(this->stickRawValue);
+	SDL_zero(this->guid);
+	SDL_zero(this->metrics);
+	resetCalibration();
+
 	// Reset axis value to 0
 	this->axisValueMap[IO::XBOX_360::AXIS::L_AXIS_X] = 0;
 	this->axisValueMap[IO::XBOX_360::AXIS::L_AXIS_Y] = 0;
@@ -53,470 +57,296 @@ Controller::Controller(SDL_GameController* controller,
 	this->buttonStateMap[IO::XBOX_360::BUTTON::DPAD_LEFT] = false;
 	this->buttonStateMap[IO::XBOX_360::BUTTON::DPAD_RIGHT] = false;
 
-	// Check if can rumble
-	if (SDL_HapticRumbleSupported(haptic))
+	// Virtual buttons. Axis and direction each button is derived from.
+	const IO::XBOX_360::AXIS virtualAxis[IO::XBOX_360::VIRTUAL_BUTTON_COUNT] =
 	{
-		if (SDL_HapticRumbleInit(haptic))
-		{
-			hapticEnabled = true;
-		}
-		else
-		{
-			hapticEnabled = false;
-		}
-	}
-}
+		IO::XBOX_360::AXIS::LT,			// LT_DIGITAL
+		IO::XBOX_360::AXIS::RT,			// RT_DIGITAL
+		IO::XBOX_360::AXIS::L_AXIS_Y,	// L_STICK_UP
+		IO::XBOX_360::AXIS::L_AXIS_Y,	// L_STICK_DOWN
+		IO::XBOX_360::AXIS::L_AXIS_X,	// L_STICK_LEFT
+		IO::XBOX_360::AXIS::L_AXIS_X,	// L_STICK_RIGHT
+		IO::XBOX_360::AXIS::R_AXIS_Y,	// R_STICK_UP
+		IO::XBOX_360::AXIS::R_AXIS_Y,	// R_STICK_DOWN
+		IO::XBOX_360::AXIS::R_AXIS_X,	// R_STICK_LEFT
+		IO::XBOX_360::AXIS::R_AXIS_X,	// R_STICK_RIGHT
+	};
 
-Controller::~Controller()
-{
-	if (this->haptic != nullptr)
+	// Y axis is already flipped in axisMoved, so up is positive.
+	const float virtualDirection[IO::XBOX_360::VIRTUAL_BUTTON_COUNT] =
 	{
-		SDL_HapticClose(this->haptic);
-	}
+		1.0f, 1.0f,
+		1.0f, -1.0f, -1.0f, 1.0f,
+		1.0f, -1.0f, -1.0f, 1.0f
+	};
 
-	if (this->controller != nullptr)
+	for (int i = 0; i < IO::XBOX_360::VIRTUAL_BUTTON_COUNT; i++)
 	{
-		SDL_GameControllerClose(controller);
-	}
-}
+		this->virtualButtons[i].axis = virtualAxis[i];
+		this->virtualButtons[i].direction = virtualDirection[i];
+		this->virtualButtons[i].pressThreshold = 0.5f;
+		this->virtualButtons[i].releaseThreshold = 0.35f;
 
-void Controller::updateButtonState(IO::XBOX_360::BUTTON button, bool state)
-{
-	if (hasButton(button))
-	{
-		this->buttonStateMap[button] = state;
+		this->buttonStateMap[static_cast<IO::XBOX_360::BUTTON>(IO::XBOX_360::VIRTUAL_BUTTON_BEGIN + i)] = false;
 	}
-}
 
-void Controller::updateAxisValue(IO::XBOX_360::AXIS axis, float value)
-{
-	if (hasAxis(axis))
+	// Generic joystick state. Allocated once here.
+	if (joystick != nullptr)
 	{
-		this->axisValueMap[axis] = value;
+		const int bitCount = SDL_max(buttonCount, 0) + SDL_max(hatCount, 0) * 4;
+		this->joystickButtonBits.assign((bitCount + 31) / 32, 0);
+		this->joystickAxisValues.assign(SDL_max(axisCount, 0), 0.0f);
+		this->joystickHatValues.assign(SDL_max(hatCount, 0), SDL_HAT_CENTERED);
+		this->joystickDirtyButtonBits.assign(this->joystickButtonBits.size(), 0);
 	}
 }
 
-const float Controller::getAxisValue(ControllerID rawValue, const float modifier)
+Controller::~Controller()
 {
-	float value = 0;
-
-	if (rawValue < AXIS_MIN)
-	{
-		value = static_cast<float>(rawValue) / SDL_AXIS_MIN_ABS_VALUE;
-	}
-	else if (rawValue > AXIS_MAX)
+	if (this->controller != nullptr)
 	{
-		value = static_cast<float>(rawValue) / SDL_AXIS_MAX_ABS_VALUE;
+		SDL_GameControllerClose(controller);
 	}
-	else
+
+	if (this->joystick != nullptr)
 	{
-		value = 0;
+		SDL_JoystickClose(joystick);
 	}
-
-	value *= (modifier);
-
-	return value;
-}
-
-void Controller::playRumble(const float strength, const Uint32 length)
-{
-	SDL_HapticRumbleStop(this->haptic);
-	SDL_HapticRumblePlay(this->haptic, strength * hapticModifier, length);
-}
-
-const bool Controller::hasButton(IO::XBOX_360::BUTTON button)
-{
-	auto find_it = this->buttonStateMap.find(button);
-	return find_it != this->buttonStateMap.end();
 }
 
-const bool Controller::hasAxis(IO::XBOX_360::AXIS axis)
+const bool Controller::getJoystickButton(const int button)
 {
-	auto find_it = this->axisValueMap.find(axis);
-	return find_it != this->axisValueMap.end();
+	return (joystickButtonBits[button >> 5] & (1u << (button & 31))) != 0;
 }
 
-ControllerManager::ControllerManager()
+void Controller::setJoystickButton(const int button, const bool state)
 {
-	//Initialize SDL
-	if (SDL_Init(SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC) < 0)
+	if (state)
 	{
-		cout << "SDL_INIT_GAMECONTROLLER or SDL_INIT_HAPTIC could not initialize!SDL Error : " << SDL_GetError() << endl;
-		active = false;
+		joystickButtonBits[button >> 5] |= (1u << (button & 31));
 	}
 	else
 	{
-		cout << "SDL is initilized" << endl;
-		active = true;
+		joystickButtonBits[button >> 5] &= ~(1u << (button & 31));
 	}
 }
 
-ControllerManager::~ControllerManager()
-{
-}
-
-ControllerManager* ControllerManager::getInstance()
+void Controller::updateButtonState(IO::XBOX_360::BUTTON button, bool state)
 {
-	if (instance == nullptr)
+	if (hasButton(button))
 	{
-		instance = new ControllerManager();
+		this->buttonStateMap[button] = state;
 	}
-
-	return instance;
 }
 
-void ControllerManager::deleteInstance()
+void Controller::updateAxisValue(IO::XBOX_360::AXIS axis, float value)
 {
-	//check if instance is alive pointer
-	if (instance != nullptr)
+	if (hasAxis(axis))
 	{
-		delete instance;
+		this->axisValueMap[axis] = value;
 	}
 }
 
-void ControllerManager::update()
+const float Controller::getAxisValue(IO::XBOX_360::AXIS axis, Sint16 rawValue, const float modifier)
 {
-	SDL_Event e;
-	while (SDL_PollEvent(&e) != 0)
+	float value = 0;
+
+	const int index = static_cast<int>(axis);
+	if (index >= 0 && index < IO::XBOX_360::AXIS_COUNT && axisCalibration[index].calibrated)
 	{
-		switch (e.type)
-		{
-		case SDL_CONTROLLERDEVICEADDED:
-		{
-			addController(e.cdevice);
-		}
-		break;
-		case SDL_CONTROLLERDEVICEREMOVED:
-		{
-			removeController(e.cdevice);
-		}
-		break;
-		case SDL_CONTROLLERBUTTONDOWN:
+		// Offset by center and rescale travel outside of deadzone to 0 ~ 1
+		const AxisCalibration& calibration = axisCalibration[index];
+		const int offset = static_cast<int>(rawValue) - calibration.center;
+
+		if (offset > calibration.deadzone)
 		{
-			buttonPressed(e.cdevice.which, e.cbutton);
+			value = static_cast<float>(offset - calibration.deadzone) / (SDL_AXIS_MAX_ABS_VALUE - calibration.center - calibration.deadzone);
 		}
-		break;
-		case SDL_CONTROLLERBUTTONUP:
+		else if (offset < -calibration.deadzone)
 		{
-			buttonReleased(e.cdevice.which, e.cbutton);
+			value = static_cast<float>(offset + calibration.deadzone) / (SDL_AXIS_MIN_ABS_VALUE + calibration.center - calibration.deadzone);
 		}
-		break;
-		case SDL_CONTROLLERAXISMOTION:
+		else
 		{
-			axisMoved(e.cdevice.which, e.caxis);
-		}
-		break;
-		default:
-			break;
+			value = 0;
 		}
-	}
-}
 
-void ControllerManager::addController(const SDL_ControllerDeviceEvent event)
-{
-	if (SDL_IsGameController(event.which)) {
-		// Get as controller
-		SDL_GameController* newController = SDL_GameControllerOpen(event.which);
-
-		if (newController != nullptr) {
-			// Convert to joystick
-			SDL_Joystick *joy = SDL_GameControllerGetJoystick(newController);
-			// Get instance id
-			const ControllerID instanceID = SDL_JoystickInstanceID(joy);
-
-			// Check duplication
-			auto find_it = this->controllers.find(instanceID);
-			if (find_it == this->controllers.end())
-			{
-				// Get number of button and axis on controller
-				const int buttonCount = SDL_JoystickNumButtons(joy);
-				const int axisCount = SDL_JoystickNumAxes(joy);
-				// Get name
-				std::string name = std::string(SDL_JoystickName(joy));
-
-				SDL_Haptic* newHaptic = nullptr;
-
-				bool hasHaptic = (SDL_JoystickIsHaptic(joy) == 1);
-				if (hasHaptic)
-				{
-					newHaptic = SDL_HapticOpenFromJoystick(joy);
-				}
-				else
-				{
-					newHaptic = nullptr;
-				}
-
-				this->controllers[instanceID] = new Controller(newController, newHaptic, name, instanceID, buttonCount, axisCount);
-
-				if (onControllerConnected)
-				{
-					onControllerConnected(instanceID);
-				}
-			}
-			else
-			{
-				// Controller with same id already exists
-				return;
-			}
+		if (value > 1.0f)
+		{
+			value = 1.0f;
 		}
-		else
+		else if (value < -1.0f)
 		{
-			// New controller is invalid
-			return;
+			value = -1.0f;
 		}
 	}
-}
-
-void ControllerManager::removeController(const SDL_ControllerDeviceEvent event)
-{
-	auto find_it = this->controllers.find(event.which);
-
-	if (find_it != this->controllers.end())
+	else
 	{
-		if (onControllerDisconnected)
-		{
-			onControllerDisconnected(event.which);
-		}
-
-		delete find_it->second;
+		value = getAxisValue(rawValue);
 	}
 
-	this->controllers[event.which] = nullptr;
-}
-
-void ControllerManager::buttonPressed(ControllerID id, const SDL_ControllerButtonEvent event)
-{
-	if (event.state == SDL_PRESSED)
-	{
-		IO::XBOX_360::BUTTON buttonEnum = static_cast<IO::XBOX_360::BUTTON>(event.button);
-		
-		auto find_it = this->controllers.find(id);
-		if (find_it != this->controllers.end())
-		{
-			(find_it->second)->updateButtonState(buttonEnum, true);
-		}
+	value *= (modifier);
 
-		if (onButtonPressed)
-		{
-			onButtonPressed(id, buttonEnum);
-		}
-	}
+	return value;
 }
 
-void ControllerManager::buttonReleased(ControllerID id, const SDL_ControllerButtonEvent event)
+const float Controller::getAxisValue(Sint16 rawValue)
 {
-	if (event.state == SDL_RELEASED)
-	{
-		IO::XBOX_360::BUTTON buttonEnum = static_cast<IO::XBOX_360::BUTTON>(event.button);
-
-		auto find_it = this->controllers.find(id);
-		if (find_it != this->controllers.end())
-		{
-			(find_it->second)->updateButtonState(buttonEnum, false);
-		}
-
-		if (onButtonReleased)
-		{
-			onButtonReleased(id, buttonEnum);
-		}
-	}
+	return IO::normalizeAxisValue(rawValue, AXIS_MIN, AXIS_MAX);
 }
 
-void ControllerManager::axisMoved(ControllerID id, const SDL_ControllerAxisEvent event)
+const float Controller::getNormalizedStickValue(IO::XBOX_360::AXIS axis)
 {
-	Controller* controller = findController(id);
-	if (controller == nullptr) { return; }
+	const int index = static_cast<int>(axis);
+	const AxisCalibration& calibration = axisCalibration[index];
+	const int center = calibration.calibrated ? calibration.center : 0;
+	const int offset = static_cast<int>(stickRawValue[index]) - center;
 
-	IO::XBOX_360::AXIS axis = static_cast<IO::XBOX_360::AXIS>(event.axis);
-	ControllerID value = event.value;
-
-	// Modifier determine whether axis is x or y. x = 1.0, y = -1.0
-	float modifier = 0;
-	float newValue = 0;
-
-	if (axis == IO::XBOX_360::AXIS::L_AXIS_X || axis == IO::XBOX_360::AXIS::R_AXIS_X)
+	if (offset >= 0)
 	{
-		modifier = 1.0f;
-		newValue = controller->getAxisValue(value, modifier);
+		return static_cast<float>(offset) / (SDL_AXIS_MAX_ABS_VALUE - center);
 	}
-	else if (axis == IO::XBOX_360::AXIS::L_AXIS_Y || axis == IO::XBOX_360::AXIS::R_AXIS_Y)
-	{
-		modifier = -1.0f;
-		newValue = controller->getAxisValue(value, modifier);
-	}
-
-	if (axis == IO::XBOX_360::AXIS::LT || axis == IO::XBOX_360::AXIS::RT)
-	{
-		newValue = controller->getAxisValue(value);
-	}
-
-	controller->updateAxisValue(axis, newValue);
-
-	if (newValue != 0)
+	else
 	{
-		if (onAxisMoved)
-		{
-			onAxisMoved(id, axis, newValue);
-		}
+		return static_cast<float>(offset) / (SDL_AXIS_MIN_ABS_VALUE + center);
 	}
 }
 
-const Sint16 ControllerManager::getMinAxisValue(ControllerID id)
+const float Controller::getStickDeadzone(const int stick)
 {
-	Controller* controller = findController(id);
-	if (controller != nullptr)
+	const AxisCalibration& calibrationX = axisCalibration[stick * 2];
+	const AxisCalibration& calibrationY = axisCalibration[stick * 2 + 1];
+
+	int deadzone = 0;
+	if (calibrationX.calibrated && calibrationY.calibrated)
 	{
-		return controller->AXIS_MIN;
+		deadzone = SDL_max(calibrationX.deadzone, calibrationY.deadzone);
 	}
 	else
 	{
-		return 0;
+		deadzone = SDL_max(static_cast<int>(AXIS_MAX), -static_cast<int>(AXIS_MIN));
 	}
+
+	return static_cast<float>(deadzone) / SDL_AXIS_MAX_ABS_VALUE;
 }
 
-void ControllerManager::setMinAxisValue(ControllerID id, Sint16 value)
+void Controller::startCalibration()
 {
-	Controller* controller = findController(id);
-	if (controller != nullptr)
-	{
-		controller->AXIS_MIN = value;
-	}
+	resetCalibration();
+	calibrating = true;
+
 }
 
-const Sint16 ControllerManager::getMaxAxisValue(ControllerID id)
+const bool Controller::sampleCalibration()
 {
-	Controller* controller = findController(id);
-	if (controller != nullptr)
-	{
-		return controller->AXIS_MAX;
-	}
-	else
+	bool finished = false;
+
+	for (int i = 0; i < CALIBRATION_AXIS_COUNT; i++)
 	{
-		return 0;
+		// External controller has no SDL handle. Last raw value it reported is its position.
+		const Sint16 rawValue = (this->controller != nullptr) ? SDL_GameControllerGetAxis(this->controller, static_cast<SDL_GameControllerAxis>(i)) : stickRawValue[i];
+		finished = addCalibrationSample(static_cast<IO::XBOX_360::AXIS>(i), rawValue) || finished;
 	}
+
+	return finished;
 }
 
-void ControllerManager::setMaxAxisValue(ControllerID id, Sint16 value)
+void Controller::resetCalibration()
 {
-	Controller* controller = findController(id);
-	if (controller != nullptr)
+	calibrating = false;
+
+	for (int i = 0; i < IO::XBOX_360::AXIS_COUNT; i++)
 	{
-		controller->AXIS_MAX = value;
+		AxisCalibration& calibration = axisCalibration[i];
+		calibration.sampleCount = 0;
+		calibration.mean = 0;
+		calibration.m2 = 0;
+		calibration.calibrated = false;
+		calibration.center = 0;
+		calibration.deadzone = 0;
 	}
 }
 
-Controller* ControllerManager::findController(ControllerID id)
+const bool Controller::addCalibrationSample(IO::XBOX_360::AXIS axis, Sint16 rawValue)
 {
-	auto find_it = this->controllers.find(id);
-	if (find_it != this->controllers.end())
+	const int index = static_cast<int>(axis);
+	if (!calibrating || index < 0 || index >= CALIBRATION_AXIS_COUNT)
 	{
-		return (find_it->second);
+		return false;
 	}
-	else
+
+	AxisCalibration& calibration = axisCalibration[index];
+	if (calibration.calibrated)
 	{
-		return nullptr;
+		return false;
 	}
-}
 
-const float ControllerManager::getHapticModifier(ControllerID id)
-{
-	Controller* controller = findController(id);
-	if (controller != nullptr)
+	// Player is moving axis. Not a noise.
+	if (rawValue < AXIS_MIN || rawValue > AXIS_MAX)
 	{
-		return controller->hapticModifier;
+		return false;
 	}
 
-	return 0.0f;
-}
-
-void ControllerManager::setHapticModifier(ControllerID id, float modifier)
-{
-	Controller* controller = findController(id);
-	if (controller != nullptr)
+	// Slow deliberate movement stays inside AXIS_MIN/AXIS_MAX. Start over from this sample.
+	if (calibration.sampleCount > 0 && std::fabs(rawValue - calibration.mean) > CALIBRATION_MAX_NOISE)
 	{
-		if (modifier < 0)
-		{
-			modifier = 0;
-		}
+		calibration.sampleCount = 0;
+		calibration.mean = 0;
+		calibration.m2 = 0;
+	}
 
-		if (modifier > 2.0f)
-		{
-			modifier = 2.0f;
-		}
+	// Update running mean and variance
+	calibration.sampleCount++;
+	const double delta = rawValue - calibration.mean;
+	calibration.mean += delta / calibration.sampleCount;
+	calibration.m2 += delta * (rawValue - calibration.mean);
 
-		controller->hapticModifier = modifier;
+	if (calibration.sampleCount < CALIBRATION_SAMPLE_COUNT)
+	{
+		return false;
 	}
-}
 
-void ControllerManager::playRumble(ControllerID id, float strength, Uint32 length)
-{
-	Controller* controller = findController(id);
-	if (controller != nullptr)
-	{
-		if (strength < 0)
-		{
-			strength = 0;
-		}
+	// Deadzone covers 4 standard deviation of noise with small margin
+	const double stddev = std::sqrt(calibration.m2 / (calibration.sampleCount - 1));
+	int deadzone = static_cast<int>(std::ceil(4.0 * stddev)) + 256;
 
-		if (length < 0)
-		{
-			length = 0;
-		}
-		controller->playRumble(strength, length);
+	if (deadzone < 1024)
+	{
+		deadzone = 1024;
 	}
-}
-
-const bool ControllerManager::isButtonPressed(ControllerID id, IO::XBOX_360::BUTTON button)
-{
-	Controller* controller = findController(id);
-	if (controller != nullptr)
+	else if (deadzone > 16384)
 	{
-		if (controller->hasButton(button))
-		{
-			return controller->buttonStateMap[button] == true;
-		}
+		deadzone = 16384;
 	}
 
-	return false;
-}
+	calibration.center = static_cast<Sint16>(std::lround(calibration.mean));
+	calibration.deadzone = static_cast<Sint16>(deadzone);
+	calibration.calibrated = true;
 
-const bool ControllerManager::isButtonReleased(ControllerID id, IO::XBOX_360::BUTTON button)
-{
-	Controller* controller = findController(id);
-	if (controller != nullptr)
+	// Calibration ends when all stick axises are calibrated
+	for (int i = 0; i < CALIBRATION_AXIS_COUNT; i++)
 	{
-		if (controller->hasButton(button))
+		if (!axisCalibration[i].calibrated)
 		{
-			return controller->buttonStateMap[button] == false;
+			return false;
 		}
 	}
 
-	return false;
+	calibrating = false;
+	return true;
 }
 
-const bool ControllerManager::isAxisMoved(ControllerID id, IO::XBOX_360::AXIS axis)
+const bool Controller::hasButton(IO::XBOX_360::BUTTON button)
 {
-	Controller* controller = findController(id);
-	if (controller != nullptr)
-	{
-		if (controller->hasAxis(axis))
-		{
-			return controller->axisValueMap[axis] != 0;
-		}
-	}
-
-	return false;
+	auto find_it = this->buttonStateMap.find(button);
+	return find_it != this->buttonStateMap.end();
 }
 
-const bool ControllerManager::hasHaptic(ControllerID id)
+const bool Controller::hasAxis(IO::XBOX_360::AXIS axis)
 {
-	Controller* controller = findController(id);
-	if (controller != nullptr)
-	{
-		return (controller->haptic != nullptr);
-	}
-	else
-	{
-		return false;
-	}
-}
\ No newline at end of file
+	auto find_it = this->axisValueMap.find(axis);
+	return find_it != this->axisValueMap.end();
+}
+
+// Default instantiation. Other instantiations include BasicControllerManager.h themselves.
+template class BasicControllerManager<>;
\ No newline at end of file
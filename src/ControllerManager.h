@@ -3,14 +3,49 @@
 
 #include <unordered_map>
 #include <functional>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include <mutex>
 #include <SDL.h>
 
 #define MAX_JOYSTICK 4
 
-class ControllerManager;
+// Matches every controller when used as controller id of wait condition.
+#define ANY_CONTROLLER -1
+
+// Number of idle samples (one per update) each axis needs to finish auto calibration
+#define CALIBRATION_SAMPLE_COUNT 64
+// Stick axises (LX, LY, RX, RY) are calibrated. Triggers rest at one end of travel and keep AXIS_MIN/AXIS_MAX.
+#define CALIBRATION_AXIS_COUNT 4
+// Sample further than this from running mean restarts calibration of axis. Stick is being moved, not resting.
+#define CALIBRATION_MAX_NOISE 1024
+
+// Default deadzone of axis. See Controller::AXIS_MIN
+#define DEFAULT_AXIS_MIN -10000
+#define DEFAULT_AXIS_MAX 10000
+
+// Magnitude of the most negative and the most positive SDL axis value
+#define AXIS_MIN_ABS_VALUE 32768.0f
+#define AXIS_MAX_ABS_VALUE 32767.0f
+
+// Number of controllers and listeners fast path can track
+#define MAX_FAST_PATH_CONTROLLER 16
+#define MAX_FAST_PATH_LISTENER 8
+
+// Policy based manager. See BasicControllerManager below and ControllerManager, its default instantiation.
+template<class SeatPolicy, class ProfilePolicy, class HapticPolicy, class DispatchPolicy, class ThreadingPolicy, class LogPolicy>
+class BasicControllerManager;
+
+class Controller;
 
 typedef Sint16 ControllerID;
 
+// Range of controller ids given to controllers added by addExternalController. SDL instance ids are smaller.
+#define EXTERNAL_CONTROLLER_ID_BEGIN 0x4000
+#define EXTERNAL_CONTROLLER_ID_END 0x7FFF
+
 namespace IO
 {
 	namespace XBOX_360
@@ -31,7 +66,19 @@ namespace IO
 			DPAD_UP,
 			DPAD_DOWN,
 			DPAD_LEFT,
-			DPAD_RIGHT
+			DPAD_RIGHT,
+
+			// Virtual buttons. Derived from axis value with hysteresis. See ControllerManager::setVirtualButtonThreshold
+			LT_DIGITAL = 32,
+			RT_DIGITAL,
+			L_STICK_UP,
+			L_STICK_DOWN,
+			L_STICK_LEFT,
+			L_STICK_RIGHT,
+			R_STICK_UP,
+			R_STICK_DOWN,
+			R_STICK_LEFT,
+			R_STICK_RIGHT
 		};
 
 		enum class AXIS
@@ -43,22 +90,297 @@ namespace IO
 			LT,
 			RT,
 		};
+
+		/**
+		*	Stick deadzone mode. See ControllerManager::setStickDeadzoneMode
+		*	AXIAL: Each axis has own deadzone. Square deadzone.
+		*	RADIAL: Circular deadzone on 2D stick vector.
+		*	SCALED_RADIAL: Circular deadzone and magnitude outside of it rescaled to start from anti deadzone.
+		*/
+		enum class DEADZONE
+		{
+			AXIAL = 0,
+			RADIAL,
+			SCALED_RADIAL
+		};
+
+		// Number of buttons and axises. BUTTON_COUNT includes virtual buttons.
+		const int BUTTON_COUNT = static_cast<int>(BUTTON::R_STICK_RIGHT) + 1;
+		const int AXIS_COUNT = static_cast<int>(AXIS::RT) + 1;
+
+		// Range of virtual buttons
+		const int VIRTUAL_BUTTON_BEGIN = static_cast<int>(BUTTON::LT_DIGITAL);
+		const int VIRTUAL_BUTTON_COUNT = BUTTON_COUNT - VIRTUAL_BUTTON_BEGIN;
 	}
 }
 
+namespace IO
+{
+	// Type of input in change journal. See InputChange
+	enum class INPUT_TYPE
+	{
+		BUTTON = 0,
+		AXIS,
+		JOYSTICK_BUTTON,
+		JOYSTICK_AXIS,
+		JOYSTICK_HAT,
+		CONNECTION
+	};
+
+	// Callback kind of metrics. See ControllerMetrics
+	enum class CALLBACK_TYPE
+	{
+		CONTROLLER_CONNECTED = 0,
+		CONTROLLER_DISCONNECTED,
+		BUTTON_PRESSED,
+		BUTTON_RELEASED,
+		AXIS_MOVED,
+		JOYSTICK_BUTTON_PRESSED,
+		JOYSTICK_BUTTON_RELEASED,
+		JOYSTICK_AXIS_MOVED
+	};
+
+	const int CALLBACK_TYPE_COUNT = static_cast<int>(CALLBACK_TYPE::JOYSTICK_AXIS_MOVED) + 1;
+
+	/**
+	*	Normalize raw axis value to -1 ~ 1.
+	*	Values from axisMin to axisMax are treated as deadzone and return 0.
+	*/
+	inline const float normalizeAxisValue(const Sint16 rawValue, const Sint16 axisMin, const Sint16 axisMax)
+	{
+		if (rawValue < axisMin)
+		{
+			return static_cast<float>(rawValue) / AXIS_MIN_ABS_VALUE;
+		}
+		else if (rawValue > axisMax)
+		{
+			return static_cast<float>(rawValue) / AXIS_MAX_ABS_VALUE;
+		}
+
+		return 0;
+	}
+}
+
+/**
+*	@struct InputChange
+*
+*	@brief Single entry of per frame change journal. See ControllerManager::getChanges
+*
+*	input is IO::XBOX_360::BUTTON, IO::XBOX_360::AXIS or joystick button/axis/hat index depends on type.
+*	Buttons are 0 (released) or 1 (pressed). Connection is 0 (disconnected) or 1 (connected) with input 0.
+*/
+struct InputChange
+{
+	ControllerID id;
+	IO::INPUT_TYPE type;
+	int input;
+	float oldValue;
+	float newValue;
+};
+
+/**
+*	Fast path listener. See ControllerManager::enableFastPath
+*	Called from the thread that pushed event, as soon as it's pushed.
+*	That can be fast path pump thread and thread calling update()/injectEvent at the same time, so listener must be reentrant.
+*	timestamp is SDL_GetPerformanceCounter() value when event is pushed.
+*	Real-time safe contract: Must not allocate, lock, block or call ControllerManager other than fast path queries.
+*/
+typedef void(*FastPathListener)(ControllerID id, IO::XBOX_360::BUTTON button, const bool pressed, const Uint64 timestamp, void* userData);
+
+struct InputWaitGroup;
+
+/**
+*	@class InputTarget
+*
+*	@brief Manager side of input sources and wait groups.
+*
+*	Every instantiation of BasicControllerManager implements this, so input sources (see EvdevBackend)
+*	and awaitables don't depend on manager policies.
+*/
+class InputTarget
+{
+public:
+	virtual ~InputTarget() {}
+
+	// See BasicControllerManager
+	virtual void injectEvent(const SDL_Event& e) = 0;
+	virtual const ControllerID addExternalController(const std::string& name) = 0;
+	virtual void removeExternalController(ControllerID id) = 0;
+	virtual void claimDevice(const Uint16 vendor, const Uint16 product) = 0;
+	virtual void releaseDevice(const Uint16 vendor, const Uint16 product) = 0;
+	virtual const bool isButtonPressed(ControllerID id, IO::XBOX_360::BUTTON button) = 0;
+	virtual void cancelWaitGroup(InputWaitGroup* group) = 0;
+};
+
+/**
+*	@class InputSource
+*
+*	@brief Input backend that feeds events to manager besides SDL event queue.
+*
+*	pollInput is called from every update() after SDL events are handled.
+*	Source reports input with InputTarget::injectEvent. See EvdevBackend.
+*	waitForInput also wakes up when wait fd becomes readable or wait timeout passes.
+*/
+class InputSource
+{
+public:
+	virtual ~InputSource() {}
+	virtual void pollInput(InputTarget* target) = 0;
+
+	// File descriptor that becomes readable when source has input. -1 if source has none.
+	virtual const int getWaitFD() { return -1; }
+
+	// Milliseconds until source has input that isn't signaled by fd. -1 if none.
+	virtual const int getWaitTimeout() { return -1; }
+};
+
+class SharedStateWriter;
+
+/**
+*	@struct InputWaiter
+*
+*	@brief Single wait condition (button press or axis threshold).
+*
+*	Intrusive node. Linked to manager's wait list of its button or axis while waiting,
+*	so waiting doesn't cost anything until that input actually fires.
+*	See ControllerAwait.h for coroutine awaitables built on this.
+*/
+struct InputWaiter
+{
+	InputWaiter* prev;
+	InputWaiter* next;
+	InputWaitGroup* group;
+
+	// Controller to wait. ANY_CONTROLLER for all controllers.
+	ControllerID id;
+
+	// Button or axis (IO::XBOX_360::BUTTON or IO::XBOX_360::AXIS)
+	bool isAxis;
+	int input;
+
+	// Axis only. Positive fires when value >= threshold, negative fires when value <= threshold.
+	float threshold;
+
+	bool linked;
+};
+
+/**
+*	@struct InputWaitGroup
+*
+*	@brief Group of waiters that resumes a single coroutine.
+*
+*	First waiter that fires wins and rest of waiters in group are unlinked.
+*	If group has deadline and none of waiters fires before it, group times out.
+*/
+struct InputWaitGroup
+{
+	InputWaiter* waiters;
+	int waiterCount;
+
+	// Resume function. Called with handle when group fires or times out.
+	void(*resume)(void* handle);
+	void* handle;
+
+	// Manager that group is linked to. nullptr if not waiting.
+	InputTarget* owner;
+
+	// Deadline in SDL ticks.
+	bool hasDeadline;
+	Uint32 deadline;
+
+	// Timed wait list and ready list link
+	InputWaitGroup* timerPrev;
+	InputWaitGroup* timerNext;
+	InputWaitGroup* readyNext;
+
+	// Result. firedIndex is -1 if timed out.
+	bool fired;
+	int firedIndex;
+	ControllerID firedID;
+	float firedValue;
+};
+
+/**
+*	@struct ControllerMetrics
+*
+*	@brief Counters of single controller. Also used for aggregate of all controllers.
+*
+*	Time is in microseconds.
+*/
+struct ControllerMetrics
+{
+	// Events by type
+	Uint64 buttonDownEvents;
+	Uint64 buttonUpEvents;
+	Uint64 axisEvents;
+
+	// Events ignored (not dispatched) because button or axis isn't supported
+	Uint64 ignoredEvents;
+
+	// Rumbles played
+	Uint64 hapticWrites;
+
+	// Callbacks called and time spent inside them. Indexed by IO::CALLBACK_TYPE.
+	Uint64 callbackCalls[IO::CALLBACK_TYPE_COUNT];
+	Uint64 callbackTime[IO::CALLBACK_TYPE_COUNT];
+};
+
+/**
+*	@struct InputMetrics
+*
+*	@brief Snapshot of input pipeline counters. See ControllerManager::getMetrics
+*
+*	Time is in microseconds. Ticks are SDL_GetTicks() value, 0 if never happened.
+*/
+struct InputMetrics
+{
+	// Sum of all controllers including disconnected ones
+	ControllerMetrics total;
+
+	// Axis and joystick events dropped because controller is unknown
+	Uint64 droppedEvents;
+
+	// Game controller button events of unknown controller. Still dispatched to callbacks with its id.
+	Uint64 unknownControllerEvents;
+
+	// Hotplug
+	Uint64 connections;
+	Uint64 disconnections;
+
+	// update() calls and time spent
+	Uint64 updates;
+	Uint64 updateTime;
+	Uint64 lastUpdateTime;
+	Uint64 maxUpdateTime;
+
+	// Events in SDL queue, sampled when update() starts handling events
+	Uint32 queueDepth;
+	Uint32 maxQueueDepth;
+
+	// Last update() and last handled event. Use to detect input stalls.
+	Uint32 lastUpdateTicks;
+	Uint32 lastEventTicks;
+
+	// Connected controllers
+	std::unordered_map<ControllerID, ControllerMetrics> controllers;
+};
+
 class Controller
 {
 private:
 	// Manager class if friend
-	friend ControllerManager;
+	template<class, class, class, class, class, class>
+	friend class BasicControllerManager;
 
 	// Private constructor. User can't make their own controller instance.
-	Controller(SDL_GameController* controller, SDL_Haptic* haptic, const std::string& name, const ControllerID id, const int buttonCount, const int axisCount);
+	// Either controller (game controller) or joystick (generic joystick) is set.
+	Controller(SDL_GameController* controller, SDL_Joystick* joystick, SDL_Haptic* haptic, const std::string& name, const ControllerID id, const int buttonCount, const int axisCount, const int hatCount);
 	// Private destructor. Only manager can delete instance.
 	~Controller();
 
-	// SDL instances holder
+	// SDL instances holder. Haptic is opened and closed by manager's haptic policy, nullptr if disabled.
 	SDL_GameController* controller;
+	SDL_Joystick* joystick;
 	SDL_Haptic* haptic;
 
 	// Informations
@@ -66,6 +388,7 @@ private:
 	ControllerID id;
 	int buttonCount;
 	int axisCount;
+	int hatCount;
 	// Note: SDL supports balls for controller, but we will focus on xbox360 for windows.
 	bool hapticEnabled;
 
@@ -73,8 +396,8 @@ private:
 	float hapticModifier;
 
 	// Maximum and minimum value that controller can make
-	const float SDL_AXIS_MAX_ABS_VALUE = 32767;
-	const float SDL_AXIS_MIN_ABS_VALUE = 32768;
+	const float SDL_AXIS_MAX_ABS_VALUE = AXIS_MAX_ABS_VALUE;
+	const float SDL_AXIS_MIN_ABS_VALUE = AXIS_MIN_ABS_VALUE;
 
 	/**
 	*	Most controller's axis aren't 'exactly' precise.
@@ -83,12 +406,87 @@ private:
 	*	Therefore, we set a minimum and maxium value and determines whether if player really made an
 	*	input physically or not by comparing input value with min/max setting.
 	*
-	*	By default, it's set to -10000, 10000 each
+	*	By default, it's set to DEFAULT_AXIS_MIN, DEFAULT_AXIS_MAX each
 	*/
 	Sint16 AXIS_MIN;
 	Sint16 AXIS_MAX;
 
-	// Button state
+	/**
+	*	Axis calibration.
+	*	While calibrating, idle samples (inside AXIS_MIN/AXIS_MAX) of stick axises update running mean and variance.
+	*	Sample further than CALIBRATION_MAX_NOISE from mean restarts the axis, so only CALIBRATION_SAMPLE_COUNT
+	*	consecutive samples of resting stick finish it. Center and deadzone are derived from noise and
+	*	used instead of AXIS_MIN/AXIS_MAX for that axis.
+	*/
+	struct AxisCalibration
+	{
+		// Running mean and variance (Welford)
+		Uint32 sampleCount;
+		double mean;
+		double m2;
+
+		// Result
+		bool calibrated;
+		Sint16 center;
+		Sint16 deadzone;
+	};
+
+	AxisCalibration axisCalibration[IO::XBOX_360::AXIS_COUNT];
+
+	// True if collecting samples
+	bool calibrating;
+
+	// Joystick GUID. Key of calibration profile.
+	SDL_JoystickGUID guid;
+
+	// Counters. Time is in performance counter ticks.
+	ControllerMetrics metrics;
+
+	// Last raw stick values, kept in every mode. Radial processing in update() reads them. Indexed by axis.
+	Sint16 stickRawValue[4];
+	bool stickPending;
+
+	/**
+	*	Virtual button setting.
+	*	Button is pressed when (axis value * direction) reaches pressThreshold and
+	*	released when it drops below releaseThreshold. Gap between two prevents flickering at boundary.
+	*	Stick diagonals press two buttons at once (8-way).
+	*/
+	struct VirtualButton
+	{
+		IO::XBOX_360::AXIS axis;
+		float direction;
+		float pressThreshold;
+		float releaseThreshold;
+	};
+
+	VirtualButton virtualButtons[IO::XBOX_360::VIRTUAL_BUTTON_COUNT];
+
+	/**
+	*	Generic joystick state. Only used when controller isn't a game controller.
+	*	Sized from reported counts once when opened.
+	*	Button bits has buttonCount buttons followed by 4 buttons (up, right, down, left) for each hat.
+	*/
+	std::vector<Uint32> joystickButtonBits;
+	std::vector<float> joystickAxisValues;
+	std::vector<Uint8> joystickHatValues;
+
+	/**
+	*	Dirty masks. Inputs changed in current frame. Cleared when next frame begins.
+	*	Button bit index is IO::XBOX_360::BUTTON value, axis bit index is IO::XBOX_360::AXIS value.
+	*	Joystick axis mask only covers first 64 axises. Use change journal for rest.
+	*/
+	bool dirty;
+	Uint64 dirtyButtons;
+	Uint32 dirtyAxes;
+	std::vector<Uint32> joystickDirtyButtonBits;
+	Uint64 dirtyJoystickAxes;
+
+	// Get/Set generic joystick button bit
+	const bool getJoystickButton(const int button);
+	void setJoystickButton(const int button, const bool state);
+
+	// Button state. Includes virtual buttons.
 	std::unordered_map<IO::XBOX_360::BUTTON, bool> buttonStateMap;
 	// Axis movement state
 	std::unordered_map<IO::XBOX_360::AXIS, float> axisValueMap;
@@ -99,11 +497,33 @@ private:
 
 	/**
 	*	Gets axis value based on each controller setting. 
+	*	Uses calibrated center and deadzone if axis is calibrated.
 	*/
-	const float getAxisValue(ControllerID rawValue, const float modifier = 1.0f);
+	const float getAxisValue(IO::XBOX_360::AXIS axis, Sint16 rawValue, const float modifier = 1.0f);
 
-	// Play rumble effect
-	void playRumble(const float strength, const Uint32 length);
+	/**
+	*	Gets axis value with AXIS_MIN/AXIS_MAX only. Used by generic joystick axises.
+	*/
+	const float getAxisValue(Sint16 rawValue);
+
+	/**
+	*	Calibration
+	*	Starts/resets calibration of all axises.
+	*	sampleCalibration adds current position of each stick axis as sample. Called once per update while calibrating.
+	*	Returns true if it finished calibration of last stick axis.
+	*/
+	void startCalibration();
+	void resetCalibration();
+	const bool sampleCalibration();
+
+	/**
+	*	Gets raw value of stick axis offset by calibrated center and normalized to -1 ~ 1.
+	*	Gets deadzone radius of stick (0 for left, 1 for right) normalized to 0 ~ 1.
+	*	Used for radial deadzone.
+	*/
+	const float getNormalizedStickValue(IO::XBOX_360::AXIS axis);
+	const float getStickDeadzone(const int stick);
+	const bool addCalibrationSample(IO::XBOX_360::AXIS axis, Sint16 rawValue);
 
 	// Check if has button or axis
 	const bool hasButton(IO::XBOX_360::BUTTON button);
@@ -112,7 +532,339 @@ public:
 };
 
 /**
-*	@class ControllerManager
+*	Policies of BasicControllerManager.
+*
+*	Each policy selects one feature of manager at compile time. Manager calls policy's static functions
+*	(or inherits its sink), so disabled features are empty inline functions and compile away from update loop.
+*/
+namespace Policy
+{
+	/**
+	*	Seat capacity. Maximum number of controllers (game controllers, generic joysticks and external ones) at once.
+	*	Device that connects while seats are full is ignored until seat becomes free.
+	*/
+	template<int N>
+	struct Seats
+	{
+		static const int CAPACITY = N;
+	};
+
+	// No limit
+	struct UnlimitedSeats
+	{
+		static const int CAPACITY = -1;
+	};
+
+	/**
+	*	Device profile.
+	*	Selects which inputs are tracked. Untracked game controller events are disabled in SDL, so they aren't even queued.
+	*	Generic joystick events are skipped when handled. Virtual buttons need both buttons and axes.
+	*/
+	struct AllDevicesProfile
+	{
+		static const bool HAS_BUTTONS = true;
+		static const bool HAS_AXES = true;
+		static const bool HAS_JOYSTICKS = true;
+	};
+
+	// Game controllers only. Generic joysticks aren't opened.
+	struct Xbox360Profile
+	{
+		static const bool HAS_BUTTONS = true;
+		static const bool HAS_AXES = true;
+		static const bool HAS_JOYSTICKS = false;
+	};
+
+	struct ButtonsOnlyProfile
+	{
+		static const bool HAS_BUTTONS = true;
+		static const bool HAS_AXES = false;
+		static const bool HAS_JOYSTICKS = false;
+	};
+
+	// Haptics on. Opens haptic device of joystick and plays rumble.
+	struct HapticsOn
+	{
+		static const bool ENABLED = true;
+		static const Uint32 INIT_FLAGS = SDL_INIT_HAPTIC;
+
+		// Returns nullptr if joystick has no haptic. rumbleEnabled is true if rumble is initialized.
+		static SDL_Haptic* open(SDL_Joystick* joystick, bool& rumbleEnabled)
+		{
+			SDL_Haptic* haptic = (SDL_JoystickIsHaptic(joystick) == 1) ? SDL_HapticOpenFromJoystick(joystick) : nullptr;
+			rumbleEnabled = (haptic != nullptr && SDL_HapticRumbleSupported(haptic) == SDL_TRUE && SDL_HapticRumbleInit(haptic) == 0);
+			return haptic;
+		}
+
+		static void close(SDL_Haptic* haptic)
+		{
+			if (haptic != nullptr)
+			{
+				SDL_HapticClose(haptic);
+			}
+		}
+
+		static void rumble(SDL_Haptic* haptic, const float strength, const Uint32 length)
+		{
+			SDL_HapticRumbleStop(haptic);
+			SDL_HapticRumblePlay(haptic, strength, length);
+		}
+	};
+
+	// Haptics off. SDL haptic subsystem isn't initialized and nothing is opened.
+	struct HapticsOff
+	{
+		static const bool ENABLED = false;
+		static const Uint32 INIT_FLAGS = 0;
+
+		static SDL_Haptic* open(SDL_Joystick*, bool& rumbleEnabled) { rumbleEnabled = false; return nullptr; }
+		static void close(SDL_Haptic*) {}
+		static void rumble(SDL_Haptic*, const float, const Uint32) {}
+	};
+
+	/**
+	*	Callback dispatch.
+	*	Static callbacks of each manager type (ControllerManager::onButtonPressed, etc). Time spent in them is
+	*	measured for metrics. Manager inherits sink, so Manager is manager type itself.
+	*/
+	struct CallbackDispatch
+	{
+		template<class Manager>
+		struct Sink
+		{
+			// Callback function when button is pressed
+			static std::function<void(ControllerID id, IO::XBOX_360::BUTTON button)> onButtonPressed;
+
+			// Callback function when button is released.
+			static std::function<void(ControllerID id, IO::XBOX_360::BUTTON button)> onButtonReleased;
+
+			// Callback function when axis moved.
+			static std::function<void(ControllerID id, IO::XBOX_360::AXIS axis, const float value)> onAxisMoved;
+
+			// Callback function when controller is connected
+			static std::function<void(ControllerID id)> onControllerConnected;
+
+			// Callback function when controller is disconnected
+			static std::function<void(ControllerID id)> onControllerDisconnected;
+
+			/**
+			*	Callback functions for generic joysticks (flight sticks, pedals, arcade encoders, etc)
+			*	Button is index of joystick button. Hat directions are buttons after last button. See getJoystickHatButton.
+			*	Connection and disconnection are reported with onControllerConnected/onControllerDisconnected.
+			*	Generic joysticks have no input waiters, virtual buttons, calibration, stick deadzone modes or fast path.
+			*	Those only apply to game controllers.
+			*/
+			static std::function<void(ControllerID id, const int button)> onJoystickButtonPressed;
+			static std::function<void(ControllerID id, const int button)> onJoystickButtonReleased;
+			static std::function<void(ControllerID id, const int axis, const float value)> onJoystickAxisMoved;
+
+		protected:
+			void beginDispatch() {}
+
+			void notifyConnected(Controller* controller, ControllerID id, const bool connected)
+			{
+				const std::function<void(ControllerID id)>& callback = connected ? onControllerConnected : onControllerDisconnected;
+				if (callback)
+				{
+					const Uint64 start = SDL_GetPerformanceCounter();
+					callback(id);
+					manager()->recordCallbackTime(controller, connected ? IO::CALLBACK_TYPE::CONTROLLER_CONNECTED : IO::CALLBACK_TYPE::CONTROLLER_DISCONNECTED, start);
+				}
+			}
+
+			void notifyButton(Controller* controller, ControllerID id, IO::XBOX_360::BUTTON button, const bool pressed)
+			{
+				const std::function<void(ControllerID id, IO::XBOX_360::BUTTON button)>& callback = pressed ? onButtonPressed : onButtonReleased;
+				if (callback)
+				{
+					const Uint64 start = SDL_GetPerformanceCounter();
+					callback(id, button);
+					manager()->recordCallbackTime(controller, pressed ? IO::CALLBACK_TYPE::BUTTON_PRESSED : IO::CALLBACK_TYPE::BUTTON_RELEASED, start);
+				}
+			}
+
+			void notifyAxis(Controller* controller, ControllerID id, IO::XBOX_360::AXIS axis, const float value)
+			{
+				if (onAxisMoved)
+				{
+					const Uint64 start = SDL_GetPerformanceCounter();
+					onAxisMoved(id, axis, value);
+					manager()->recordCallbackTime(controller, IO::CALLBACK_TYPE::AXIS_MOVED, start);
+				}
+			}
+
+			void notifyJoystickButton(Controller* controller, ControllerID id, const int button, const bool pressed)
+			{
+				const std::function<void(ControllerID id, const int button)>& callback = pressed ? onJoystickButtonPressed : onJoystickButtonReleased;
+				if (callback)
+				{
+					const Uint64 start = SDL_GetPerformanceCounter();
+					callback(id, button);
+					manager()->recordCallbackTime(controller, pressed ? IO::CALLBACK_TYPE::JOYSTICK_BUTTON_PRESSED : IO::CALLBACK_TYPE::JOYSTICK_BUTTON_RELEASED, start);
+				}
+			}
+
+			void notifyJoystickAxis(Controller* controller, ControllerID id, const int axis, const float value)
+			{
+				if (onJoystickAxisMoved)
+				{
+					const Uint64 start = SDL_GetPerformanceCounter();
+					onJoystickAxisMoved(id, axis, value);
+					manager()->recordCallbackTime(controller, IO::CALLBACK_TYPE::JOYSTICK_AXIS_MOVED, start);
+				}
+			}
+
+		private:
+			Manager* manager()
+			{
+				return static_cast<Manager*>(this);
+			}
+		};
+	};
+
+	/**
+	*	Batched dispatch.
+	*	Events are collected during update() and read with getEvents() after. Cleared when next update() begins.
+	*	Nothing is called from update(), so callback metrics stay 0.
+	*/
+	struct BatchedDispatch
+	{
+		struct Event
+		{
+			// Callback that would have been called
+			IO::CALLBACK_TYPE type;
+			ControllerID id;
+
+			// IO::XBOX_360::BUTTON, IO::XBOX_360::AXIS or joystick button/axis index. 0 for connection.
+			int input;
+
+			// Axis value. 1 or 0 for buttons and connection.
+			float value;
+		};
+
+		template<class Manager>
+		struct Sink
+		{
+			Sink()
+			{
+				events.reserve(64);
+			}
+
+			// Events of last update() in order
+			const std::vector<Event>& getEvents() const
+			{
+				return events;
+			}
+
+		protected:
+			void beginDispatch()
+			{
+				events.clear();
+			}
+
+			void notifyConnected(Controller*, ControllerID id, const bool connected)
+			{
+				push(connected ? IO::CALLBACK_TYPE::CONTROLLER_CONNECTED : IO::CALLBACK_TYPE::CONTROLLER_DISCONNECTED, id, 0, connected ? 1.0f : 0);
+			}
+
+			void notifyButton(Controller*, ControllerID id, IO::XBOX_360::BUTTON button, const bool pressed)
+			{
+				push(pressed ? IO::CALLBACK_TYPE::BUTTON_PRESSED : IO::CALLBACK_TYPE::BUTTON_RELEASED, id, static_cast<int>(button), pressed ? 1.0f : 0);
+			}
+
+			void notifyAxis(Controller*, ControllerID id, IO::XBOX_360::AXIS axis, const float value)
+			{
+				push(IO::CALLBACK_TYPE::AXIS_MOVED, id, static_cast<int>(axis), value);
+			}
+
+			void notifyJoystickButton(Controller*, ControllerID id, const int button, const bool pressed)
+			{
+				push(pressed ? IO::CALLBACK_TYPE::JOYSTICK_BUTTON_PRESSED : IO::CALLBACK_TYPE::JOYSTICK_BUTTON_RELEASED, id, button, pressed ? 1.0f : 0);
+			}
+
+			void notifyJoystickAxis(Controller*, ControllerID id, const int axis, const float value)
+			{
+				push(IO::CALLBACK_TYPE::JOYSTICK_AXIS_MOVED, id, axis, value);
+			}
+
+		private:
+			std::vector<Event> events;
+
+			void push(const IO::CALLBACK_TYPE type, ControllerID id, const int input, const float value)
+			{
+				Event event;
+				event.type = type;
+				event.id = id;
+				event.input = input;
+				event.value = value;
+				events.push_back(event);
+			}
+		};
+	};
+
+	// Poll only. No callbacks or events. Query state, change journal or dirty masks after update().
+	struct PollOnlyDispatch
+	{
+		template<class Manager>
+		struct Sink
+		{
+		protected:
+			void beginDispatch() {}
+			void notifyConnected(Controller*, ControllerID, const bool) {}
+			void notifyButton(Controller*, ControllerID, IO::XBOX_360::BUTTON, const bool) {}
+			void notifyAxis(Controller*, ControllerID, IO::XBOX_360::AXIS, const float) {}
+			void notifyJoystickButton(Controller*, ControllerID, const int, const bool) {}
+			void notifyJoystickAxis(Controller*, ControllerID, const int, const float) {}
+		};
+	};
+
+	// Single threaded. No locking.
+	struct SingleThreaded
+	{
+		struct Mutex {};
+
+		struct Guard
+		{
+			explicit Guard(Mutex&) {}
+		};
+	};
+
+	/**
+	*	Multi threaded. Every public function locks manager, except wakeUp and fast path queries which are already
+	*	thread safe. Recursive, so callbacks can query manager. waitForInput doesn't hold lock while sleeping.
+	*/
+	struct MultiThreaded
+	{
+		typedef std::recursive_mutex Mutex;
+		typedef std::lock_guard<std::recursive_mutex> Guard;
+	};
+
+	// Logging sinks
+	struct CoutLog
+	{
+		static void write(const char* message, const char* detail = "")
+		{
+			std::cout << message << detail << std::endl;
+		}
+	};
+
+	struct NullLog
+	{
+		static void write(const char*, const char* = "") {}
+	};
+
+	template<class Manager> std::function<void(ControllerID, IO::XBOX_360::BUTTON)> CallbackDispatch::Sink<Manager>::onButtonPressed;
+	template<class Manager> std::function<void(ControllerID, IO::XBOX_360::BUTTON)> CallbackDispatch::Sink<Manager>::onButtonReleased;
+	template<class Manager> std::function<void(ControllerID, IO::XBOX_360::AXIS, const float)> CallbackDispatch::Sink<Manager>::onAxisMoved;
+	template<class Manager> std::function<void(ControllerID)> CallbackDispatch::Sink<Manager>::onControllerConnected;
+	template<class Manager> std::function<void(ControllerID)> CallbackDispatch::Sink<Manager>::onControllerDisconnected;
+	template<class Manager> std::function<void(ControllerID, const int)> CallbackDispatch::Sink<Manager>::onJoystickButtonPressed;
+	template<class Manager> std::function<void(ControllerID, const int)> CallbackDispatch::Sink<Manager>::onJoystickButtonReleased;
+	template<class Manager> std::function<void(ControllerID, const int, const float)> CallbackDispatch::Sink<Manager>::onJoystickAxisMoved;
+}
+
+/**
+*	@class BasicControllerManager
 *
 *	@brief Manages multiple controllers connections.
 *
@@ -121,35 +873,230 @@ public:
 *	This class manages multiple xbox 360 controllers.
 *	Here are list of features supported
 *	- Connection detection
-*	
+*
+*	Seat capacity, device profile, haptics, dispatch style, threading model and logging sink are selected
+*	by policies (see namespace Policy). ControllerManager is the default instantiation. Other instantiations
+*	are singletons of their own and need BasicControllerManager.h included in one source file:
+*
+*	typedef BasicControllerManager<Policy::Seats<2>, Policy::ButtonsOnlyProfile, Policy::HapticsOff, Policy::PollOnlyDispatch> ButtonManager;
+*	template class BasicControllerManager<Policy::Seats<2>, Policy::ButtonsOnlyProfile, Policy::HapticsOff, Policy::PollOnlyDispatch>;
 */
-class ControllerManager
+template<class SeatPolicy = Policy::UnlimitedSeats,
+	class ProfilePolicy = Policy::AllDevicesProfile,
+	class HapticPolicy = Policy::HapticsOn,
+	class DispatchPolicy = Policy::CallbackDispatch,
+	class ThreadingPolicy = Policy::SingleThreaded,
+	class LogPolicy = Policy::CoutLog>
+class BasicControllerManager final : public InputTarget, public DispatchPolicy::template Sink<BasicControllerManager<SeatPolicy, ProfilePolicy, HapticPolicy, DispatchPolicy, ThreadingPolicy, LogPolicy>>
 {
 private:
+	typedef typename DispatchPolicy::template Sink<BasicControllerManager> DispatchSink;
+
+	// Callback sink measures callback time with recordCallbackTime
+	friend DispatchSink;
+
 	// Constructor
-	ControllerManager();
+	BasicControllerManager();
 
 	// Destructor
-	~ControllerManager();
+	~BasicControllerManager();
 
 	//Singleton instance
-	static ControllerManager* instance;
+	static BasicControllerManager* instance;
 
 	// True if sdl is usable.
 	bool active;
 
+	// Locked by public functions. Empty if single threaded.
+	typename ThreadingPolicy::Mutex mutex;
+
+	// Number of controllers taking seat
+	int seatCount;
+
+	// Add SDL devices that aren't added yet while there are free seats. Only used if seat capacity is limited.
+	void fillFreeSeats();
+
+	// Custom SDL event type pushed by wakeUp(). (Uint32)-1 if it couldn't be registered
+	Uint32 wakeUpEventType;
+
+	/**
+	*	Fast path state.
+	*	Written from event watch thread, so everything is atomic and fixed size.
+	*	Slot's id is -1 if empty. Button bit index is IO::XBOX_360::BUTTON value.
+	*/
+	struct FastPathSlot
+	{
+		std::atomic<Sint32> id;
+		std::atomic<Uint64> buttons;
+		std::atomic<Uint64> timestamp;
+	};
+
+	struct FastPathListenerEntry
+	{
+		FastPathListener listener;
+		void* userData;
+	};
+
+	FastPathSlot fastPathSlots[MAX_FAST_PATH_CONTROLLER];
+	FastPathListenerEntry fastPathListeners[MAX_FAST_PATH_LISTENER];
+	std::atomic<int> fastPathListenerCount;
+	bool fastPathEnabled;
+
+	// Optional thread that polls joysticks, so events are pushed (and watch is called) between updates
+	SDL_Thread* fastPathPumpThread;
+	std::atomic<bool> fastPathPumpRunning;
+	Uint32 fastPathPumpInterval;
+
+	// Event watch. Called by SDL as soon as event is pushed.
+	static int fastPathWatch(void* userData, SDL_Event* event);
+	static int fastPathPump(void* userData);
+
+	// Assign or release fast path slot of controller
+	void assignFastPathSlot(ControllerID id);
+	void releaseFastPathSlot(ControllerID id);
+
 	// Store controller
 	std::unordered_map<ControllerID/*SDL controller id*/, Controller*> controllers;
 
+	/**
+	*	Calibration profile.
+	*	Calibrated center and deadzone of each axis, stored per joystick GUID.
+	*/
+	struct CalibrationProfile
+	{
+		Uint8 calibratedMask;
+		Sint16 center[IO::XBOX_360::AXIS_COUNT];
+		Sint16 deadzone[IO::XBOX_360::AXIS_COUNT];
+	};
+
+	// Calibration profiles. Key is 16 bytes of joystick GUID.
+	std::unordered_map<std::string, CalibrationProfile> calibrationProfiles;
+
+	// Profile file path. Empty if profiles aren't persisted.
+	std::string calibrationProfilePath;
+
+	// True if profiles changed since last load or save
+	bool calibrationProfilesDirty;
+
+	// Controllers that are calibrating. Sampled once per update.
+	std::vector<ControllerID> calibratingControllers;
+
+	// True if new controller without profile starts calibration automatically
+	bool autoCalibration;
+
+	// Counters. Time is in performance counter ticks until snapshot.
+	InputMetrics metrics;
+
+	// Stick processing setting
+	IO::XBOX_360::DEADZONE stickDeadzoneMode;
+	float outerDeadzone;
+	float antiDeadzone;
+
+	// Input sources polled by update()
+	std::vector<InputSource*> inputSources;
+
+	/**
+	*	Device claimed by input source. See claimDevice
+	*	Counted, because input source may read several pads of same model.
+	*/
+	struct DeviceClaim
+	{
+		Uint16 vendor;
+		Uint16 product;
+		int count;
+	};
+
+	std::vector<DeviceClaim> deviceClaims;
+
+	// Check if SDL device (joystick device index or opened joystick) is claimed by input source
+	const bool isClaimedDevice(const Uint16 vendor, const Uint16 product);
+	const bool isClaimedDeviceIndex(const int deviceIndex);
+
+	// Add SDL device at device index as game controller or generic joystick
+	void addDeviceIndex(const int deviceIndex);
+
+	// Next id of external controller
+	ControllerID nextExternalID;
+
+	/**
+	*	Wait for SDL event or input source fd.
+	*	@param fds File descriptors of input sources, collected by waitForInput.
+	*	@return 1 if SDL event is stored in e, 2 if input source is readable, 0 if timed out.
+	*/
+	const int waitEventOrSource(SDL_Event& e, const int* fds, const int count, const int timeout);
+
+	// Change journal of current frame and controllers that have dirty mask set
+	std::vector<InputChange> changeJournal;
+	std::vector<ControllerID> dirtyControllers;
+
+	// Shared memory export. nullptr if disabled.
+	SharedStateWriter* sharedStateWriter;
+
+	// Journal size when shared state was last published
+	size_t sharedStatePublished;
+
+	// Controllers that has stick values waiting for processing
+	std::vector<ControllerID> pendingStickControllers;
+
+	// Sticks gathered for processing in SoA form. Reused every update.
+	std::vector<float> stickX;
+	std::vector<float> stickY;
+	std::vector<float> stickDeadzone;
+	std::vector<Controller*> stickOwner;
+
+	// Intrusive wait lists for each button and axis. Head of list, nullptr if empty.
+	InputWaiter* buttonWaitList[IO::XBOX_360::BUTTON_COUNT];
+	InputWaiter* axisWaitList[IO::XBOX_360::AXIS_COUNT];
+
+	// Wait groups that has deadline and the closest deadline among them.
+	InputWaitGroup* timedWaitList;
+	Uint32 nextWaitDeadline;
+
+	// Wait groups that are fired and about to resume.
+	InputWaitGroup* readyWaitList;
+
+	/**
+	*	Begin frame
+	*	Clears change journal and dirty masks of previous frame.
+	*/
+	void beginFrame();
+
+	/**
+	*	Process events
+	*	Handles all pending events, processes sticks and timed out waiters.
+	*	@param firstEvent Event already taken from queue (by waitForInput). Handled and measured as first of queue.
+	*/
+	void processEvents(const SDL_Event* firstEvent = nullptr);
+
+	/**
+	*	Record change
+	*	Sets dirty mask of controller and adds entry to change journal.
+	*/
+	void recordChange(Controller* controller, const IO::INPUT_TYPE type, const int input, const float oldValue, const float newValue);
+
+	/**
+	*	Handle single SDL event.
+	*	Shared by update() and waitForInput().
+	*/
+	void handleEvent(const SDL_Event& e);
+
 	/**
 	*	Add controller to manager
+	*	Devices claimed by input source are ignored.
 	*/
 	void addController(const SDL_ControllerDeviceEvent event);
 
+	/**
+	*	Add generic joystick to manager
+	*	Joysticks that are game controllers are ignored because addController handles them.
+	*	Devices claimed by input source are ignored.
+	*/
+	void addJoystick(const SDL_JoyDeviceEvent event);
+
 	/**
 	*	Remove controller from manager
 	*/
-	void removeController(const SDL_ControllerDeviceEvent event);
+	void removeController(ControllerID id);
 
 	/**
 	*	Button pressed
@@ -171,6 +1118,110 @@ private:
 	*/
 	void axisMoved(ControllerID id, const SDL_ControllerAxisEvent event);
 
+	/**
+	*	Calibration profile
+	*	Applies stored profile to controller, or stores controller's calibration as profile.
+	*	Stored profile is kept in memory until saveCalibrationProfiles.
+	*/
+	const bool applyCalibrationProfile(Controller* controller);
+	void storeCalibrationProfile(Controller* controller);
+
+	// Start calibration of controller and track it for per update sampling
+	void beginCalibration(Controller* controller);
+
+	/**
+	*	Process calibration
+	*	Samples current stick position of calibrating controllers. SDL only reports axis when it changes,
+	*	so resting stick is sampled here instead of from events.
+	*/
+	void processCalibration();
+
+	/**
+	*	Metrics
+	*	Adds time elapsed since start (performance counter) to callback time of type, of controller and total.
+	*/
+	void recordCallbackTime(Controller* controller, const IO::CALLBACK_TYPE type, const Uint64 start);
+
+	// Counts event that is ignored because button or axis isn't supported
+	void countIgnoredEvent(Controller* controller);
+
+	// Write dirty controllers to shared memory
+	void publishSharedState();
+
+	// Write single controller to its shared memory slot
+	void exportControllerState(const ControllerID id);
+
+	// Clamp stick value to -1 ~ 1
+	static float clampStickValue(const float value);
+
+	// Converts performance counter ticks of metrics to microseconds
+	static const Uint64 toMicroseconds(const Uint64 counter);
+	static void convertMetricsTime(ControllerMetrics& metrics);
+
+	// Writes controller metrics with prefix. Json if json is true.
+	static void dumpControllerMetrics(std::ostream& out, const ControllerMetrics& metrics, const std::string& prefix, const bool json);
+
+	// Little endian Uint16 of calibration profile file
+	static void writeUint16(std::ostream& out, const Uint16 value);
+	static const Uint16 readUint16(std::istream& in);
+
+	/**
+	*	Apply axis value
+	*	Stores new axis value, then calls onAxisMoved, resumes waiters and updates virtual buttons.
+	*/
+	void applyAxisValue(Controller* controller, ControllerID id, IO::XBOX_360::AXIS axis, const float newValue);
+
+	/**
+	*	Process sticks
+	*	Gathers sticks of all controllers that moved during update and processes them in single pass.
+	*	Only used when stick deadzone mode isn't axial.
+	*/
+	void processSticks();
+
+	/**
+	*	Generic joystick input
+	*	Updates state sized by reported counts and calls joystick callbacks.
+	*	Events from game controllers are skipped because they are handled as controller events.
+	*	Deliberately separate from buttonPressed/axisMoved: input waiters, virtual buttons, calibration, stick deadzone
+	*	and fast path are keyed by IO::XBOX_360 layout, which generic joystick doesn't have.
+	*	Metrics, change journal (dirty state) and shared state export are shared.
+	*/
+	void joystickButtonChanged(const SDL_JoyButtonEvent event);
+	void joystickAxisMoved(const SDL_JoyAxisEvent event);
+	void joystickHatMoved(const SDL_JoyHatEvent event);
+
+	// Dispatch generic joystick button. Hat directions are dispatched as button too.
+	void dispatchJoystickButton(Controller* controller, const int button, const bool pressed);
+
+	/**
+	*	Dispatch button
+	*	Updates button state, then calls onButtonPressed/onButtonReleased and resumes waiters.
+	*	Shared by real and virtual buttons. controller can be nullptr.
+	*/
+	void dispatchButton(Controller* controller, ControllerID id, IO::XBOX_360::BUTTON button, const bool pressed);
+
+	/**
+	*	Update virtual buttons
+	*	Presses or releases virtual buttons derived from axis.
+	*/
+	void updateVirtualButtons(Controller* controller, ControllerID id, IO::XBOX_360::AXIS axis, const float value);
+
+	/**
+	*	Wait list.
+	*	Fires wait groups waiting for button or axis, or timed out, then resumes them.
+	*	Groups are collected first and resumed after, so resumed coroutine can wait again safely.
+	*/
+	void resumeButtonWaiters(ControllerID id, IO::XBOX_360::BUTTON button);
+	void resumeAxisWaiters(ControllerID id, IO::XBOX_360::AXIS axis, const float value);
+	void resumeTimedOutWaiters();
+	void resumeReadyWaiters();
+
+	// Unlinks all waiters in group from wait lists and timed wait list.
+	void unlinkWaitGroup(InputWaitGroup* group);
+
+	// Waits closest deadline can wait in milliseconds. -1 if there is no deadline
+	const int getWaitDeadlineTimeout();
+
 	/**
 	*	Finds controller by id.
 	*	Nullptr if doesn't exists
@@ -178,17 +1229,17 @@ private:
 	Controller* findController(ControllerID id);
 public:
 	// Get instance
-	static ControllerManager* getInstance();
+	static BasicControllerManager* getInstance();
 
 	// Destroy instance.
 	static void deleteInstance();
 
 	// Prevent copying or assigning instance
-	ControllerManager(ControllerManager const&) = delete;
-	void operator=(ControllerManager const&) = delete;
+	BasicControllerManager(BasicControllerManager const&) = delete;
+	void operator=(BasicControllerManager const&) = delete;
 
-	const float SDL_AXIS_MAX_ABS_VALUE = 32767;
-	const float SDL_AXIS_MIN_ABS_VALUE = 32768;
+	const float SDL_AXIS_MAX_ABS_VALUE = AXIS_MAX_ABS_VALUE;
+	const float SDL_AXIS_MIN_ABS_VALUE = AXIS_MIN_ABS_VALUE;
 
 	/**
 	*	Update manager.
@@ -196,20 +1247,55 @@ public:
 	*/
 	void update();
 
-	// Callback function when button is pressed
-	static std::function<void(ControllerID id, IO::XBOX_360::BUTTON button)> onButtonPressed;
+	/**
+	*	Wait for input.
+	*	Sleeps until SDL receives an event, wakeUp() is called or timeout (in milliseconds) expires,
+	*	then handles every pending event like update() does. Pass negative timeout to wait forever.
+	*	@return true if woke up by event, false if timed out.
+	*	@note Use this instead of update() in idle loops (menu, attract screen, etc) so it doesn't spin the cpu.
+	*/
+	const bool waitForInput(const int timeout);
 
-	// Callback function when button is released.
-	static std::function<void(ControllerID id, IO::XBOX_360::BUTTON button)> onButtonReleased;
+	/**
+	*	Wake up waitForInput().
+	*	@note Safe to call from any thread.
+	*/
+	void wakeUp();
 
-	// Callback function when axis moved.
-	static std::function<void(ControllerID id, IO::XBOX_360::AXIS axis, const float value)> onAxisMoved;
+	/**
+	*	Add/Remove input source.
+	*	Sources are polled by every update() after SDL events. Manager doesn't own them.
+	*/
+	void addInputSource(InputSource* source);
+	void removeInputSource(InputSource* source);
 
-	// Callback function when controller is connected
-	static std::function<void(ControllerID id)> onControllerConnected;
+	/**
+	*	Add external controller.
+	*	Controller that isn't opened by SDL but reported by input source. Treated same as xbox 360 game controller.
+	*	@return Controller id between EXTERNAL_CONTROLLER_ID_BEGIN and EXTERNAL_CONTROLLER_ID_END. -1 if all ids or seats are in use.
+	*/
+	const ControllerID addExternalController(const std::string& name) override;
 
-	// Callback function when controller is disconnected
-	static std::function<void(ControllerID id)> onControllerDisconnected;
+	// Remove external controller. Calls onControllerDisconnected.
+	void removeExternalController(ControllerID id) override;
+
+	/**
+	*	Claim/Release device model for input source that reads it directly (e.g. EvdevBackend).
+	*	SDL doesn't add claimed vendor/product as controller or joystick, and ones already added are removed,
+	*	so same pad isn't reported twice. Other devices, including generic joysticks, are unaffected.
+	*	Claims are counted. When last claim is released, SDL devices of that model are added again.
+	*/
+	void claimDevice(const Uint16 vendor, const Uint16 product) override;
+	void releaseDevice(const Uint16 vendor, const Uint16 product) override;
+
+	/**
+	*	Inject event.
+	*	Handles event as if it came from SDL event queue. Used by input sources and for replaying recorded input.
+	*	Button events also go through fast path (if enabled) at this point, since they never pass SDL event watch.
+	*/
+	void injectEvent(const SDL_Event& e) override;
+
+	// Callbacks (onButtonPressed, etc) are inherited from dispatch policy's sink. See Policy::CallbackDispatch.
 
 	// Get/Set minimum axis value
 	const Sint16 getMinAxisValue(ControllerID id);
@@ -219,20 +1305,209 @@ public:
 	const Sint16 getMaxAxisValue(ControllerID id);
 	void setMaxAxisValue(ControllerID id, Sint16 value);
 
+	/**
+	*	Set stick deadzone mode.
+	*	AXIAL (default) processes each axis on event with square deadzone.
+	*	RADIAL and SCALED_RADIAL process X and Y of stick together with circular deadzone, which removes
+	*	sticky cardinal directions. Sticks of all controllers are processed together at the end of update().
+	*	Deadzone radius is calibrated deadzone if calibrated, AXIS_MAX otherwise.
+	*	Switching to radial mode reprocesses current stick positions in next update().
+	*/
+	void setStickDeadzoneMode(const IO::XBOX_360::DEADZONE mode);
+	const IO::XBOX_360::DEADZONE getStickDeadzoneMode();
+
+	/**
+	*	Set outer deadzone and anti deadzone of radial modes.
+	*	Outer deadzone (0 ~ 1) is radius that reaches full tilt. 1.0 by default.
+	*	Anti deadzone (0 ~ 1) is smallest magnitude outside of deadzone in SCALED_RADIAL. 0 by default.
+	*/
+	void setOuterDeadzone(float value);
+	void setAntiDeadzone(float value);
+
+	/**
+	*	Set virtual button threshold.
+	*	Virtual button (LT_DIGITAL, L_STICK_UP, etc) is pressed when its axis value reaches pressThreshold
+	*	and released when it drops below releaseThreshold. releaseThreshold is clamped to pressThreshold.
+	*	Default is 0.5 and 0.35.
+	*/
+	void setVirtualButtonThreshold(ControllerID id, IO::XBOX_360::BUTTON button, float pressThreshold, float releaseThreshold);
+
+	/**
+	*	Auto calibration.
+	*	When enabled, controller that doesn't have calibration profile starts calibration on connection.
+	*	Calibration collects axis noise while axises are idle and derives tight deadzone and center offset
+	*	for each axis. Disabled by default.
+	*/
+	void setAutoCalibration(const bool enabled);
+	const bool isAutoCalibrationEnabled();
+
+	// Start, check or reset calibration manually. Reset also removes stored profile (in memory until saved).
+	void startCalibration(ControllerID id);
+	const bool isCalibrating(ControllerID id);
+	void resetCalibration(ControllerID id);
+
+	// Get calibrated center and deadzone of axis. 0 if not calibrated.
+	const Sint16 getAxisCenter(ControllerID id, IO::XBOX_360::AXIS axis);
+	const Sint16 getAxisDeadzone(ControllerID id, IO::XBOX_360::AXIS axis);
+
+	/**
+	*	Load calibration profiles from file.
+	*	Profiles are keyed by joystick GUID, so controller that connects again gets its calibration instantly.
+	*	Path is kept for saveCalibrationProfiles. Profiles in file are merged only if whole file is valid.
+	*	@return true if file is loaded. Path is kept even if file doesn't exist yet.
+	*	@note GUID identifies controller model, so same model of controllers share profile.
+	*/
+	const bool loadCalibrationProfiles(const std::string& path);
+
+	/**
+	*	Save calibration profiles to path given to loadCalibrationProfiles.
+	*	Finished calibrations are never saved from update(). Call this outside of frame (e.g. on exit or in menu)
+	*	when hasUnsavedCalibrationProfiles is true.
+	*/
+	const bool saveCalibrationProfiles();
+	const bool hasUnsavedCalibrationProfiles();
+
+	/**
+	*	Get change journal.
+	*	Every input that changed in last update() (or waitForInput()), in order of change.
+	*	Iterate this to replicate or redraw only what changed instead of querying every input.
+	*	@note Valid until next update() or waitForInput().
+	*/
+	const std::vector<InputChange>& getChanges();
+
+	// Controllers that changed in last update().
+	const std::vector<ControllerID>& getDirtyControllers();
+
+	/**
+	*	Get dirty masks.
+	*	Bit is set if button (bit index is IO::XBOX_360::BUTTON value) or axis (bit index is IO::XBOX_360::AXIS value)
+	*	changed in last update().
+	*/
+	const Uint64 getDirtyButtons(ControllerID id);
+	const Uint32 getDirtyAxes(ControllerID id);
+
+	// Dirty state of generic joystick inputs. Hat changes are reported as buttons.
+	const bool isJoystickButtonDirty(ControllerID id, const int button);
+	const Uint64 getDirtyJoystickAxes(ControllerID id);
+
+	/**
+	*	Export controller state to POSIX shared memory.
+	*	Connection, buttons and normalized axes of every controller are written to segment (see SharedState.h)
+	*	at the end of each update(), guarded by seqlock. Other processes map it with SharedStateReader.
+	*	Only controllers that changed are rewritten.
+	*	@param name Segment name (e.g. "/controller_state").
+	*	@return False if segment can't be created or platform has no shm_open.
+	*/
+	const bool enableSharedStateExport(const std::string& name);
+
+	// Stop export and unlink segment
+	void disableSharedStateExport();
+
+	const bool isSharedStateExportEnabled();
+
+	/**
+	*	Get metrics.
+	*	Returns snapshot of counters (events, dropped/ignored events, hotplug, queue depth,
+	*	time per update, time in each callback type, haptic writes) of all and each connected controller.
+	*/
+	const InputMetrics getMetrics();
+
+	/**
+	*	Dump metrics as text or json.
+	*	Text is one "name value" per line. Controllers' counters are prefixed with "controller.<id>."
+	*	Callback counters are named by callback, e.g. "callbackTime.buttonPressed" (nested object in json).
+	*/
+	const std::string dumpMetrics(const bool json = false);
+
+	// Reset all counters to 0
+	void resetMetrics();
+
 	// Haptic modifier (Vibration power)
 	const float getHapticModifier(ControllerID id);
 	void setHapticModifier(ControllerID id, float modifier);
 
 	// Check button state and axis value
-	const bool isButtonPressed(ControllerID id, IO::XBOX_360::BUTTON button);
+	const bool isButtonPressed(ControllerID id, IO::XBOX_360::BUTTON button) override;
 	const bool isButtonReleased(ControllerID id, IO::XBOX_360::BUTTON button);
 	const bool isAxisMoved(ControllerID id, IO::XBOX_360::AXIS axis);
 
 	// Check if has haptic
 	const bool hasHaptic(ControllerID id);
 
+	// Check if controller is game controller (including external ones). False if generic joystick.
+	const bool isGameController(ControllerID id);
+
+	// Number of buttons, axises and hats reported by device
+	const int getButtonCount(ControllerID id);
+	const int getAxisCount(ControllerID id);
+	const int getHatCount(ControllerID id);
+
+	/**
+	*	Generic joystick state.
+	*	Hat value is combination of SDL_HAT_UP, SDL_HAT_RIGHT, SDL_HAT_DOWN and SDL_HAT_LEFT.
+	*	getJoystickHatButton gets button index of hat direction (0 up, 1 right, 2 down, 3 left). -1 if invalid.
+	*/
+	const bool isJoystickButtonPressed(ControllerID id, const int button);
+	const float getJoystickAxisValue(ControllerID id, const int axis);
+	const Uint8 getJoystickHat(ControllerID id, const int hat);
+	const int getJoystickHatButton(ControllerID id, const int hat, const int direction);
+
 	// Play rumble.
 	void playRumble(ControllerID id, float strength, Uint32 length);
+
+	/**
+	*	Enable/Disable fast path.
+	*	Registers SDL event watch that updates button state and calls fast path listeners as soon as
+	*	SDL pushes button event. Normal dispatch in update() is unchanged.
+	*	Watch runs on the thread that pushes event. SDL2 pushes controller events while pumping, which is
+	*	inside update() unless something else pumps. Without pump thread, watch runs in the same update() as
+	*	normal dispatch, so it gives neither lower latency nor more precise timestamp.
+	*	@param pumpInterval If not 0, starts thread that calls SDL_JoystickUpdate every pumpInterval ms,
+	*	so listeners see button events between updates. Supported on Windows and Linux only. Other joystick
+	*	backends (e.g. macOS IOKit run loop) must be updated on the thread that set them up, so there it's ignored.
+	*	While pump thread runs, update() still pumps too, so listeners run on both threads, possibly at the same time.
+	*/
+	void enableFastPath(const Uint32 pumpInterval = 0);
+	void disableFastPath();
+	const bool isFastPathEnabled();
+
+	// Check if fast path pump thread is running. False if pumpInterval was 0 or platform isn't supported.
+	const bool isFastPathPumpRunning();
+
+	/**
+	*	Add fast path listener.
+	*	Listener must follow real-time safe contract. See FastPathListener.
+	*	Can be added while fast path is enabled. Listeners can only be cleared while disabled.
+	*	@return false if there are already MAX_FAST_PATH_LISTENER listeners.
+	*/
+	const bool addFastPathListener(FastPathListener listener, void* userData);
+	const bool clearFastPathListeners();
+
+	/**
+	*	Fast path queries. Lock free and safe to call from any thread, including fast path listeners.
+	*	Timestamp is SDL_GetPerformanceCounter() value of last button event received by fast path. 0 if none.
+	*/
+	const bool isButtonPressedFast(ControllerID id, IO::XBOX_360::BUTTON button);
+	const Uint64 getFastPathTimestamp(ControllerID id);
+
+	/**
+	*	Suspend wait group.
+	*	Links all waiters in group to wait lists. Group is resumed from update() when one of them fires.
+	*	@note Used by awaitables in ControllerAwait.h. Group and waiters must stay alive while linked.
+	*/
+	void suspendWaitGroup(InputWaitGroup* group);
+
+	/**
+	*	Cancel wait group.
+	*	Unlinks group without resuming it. Call this if waiting coroutine is destroyed.
+	*/
+	void cancelWaitGroup(InputWaitGroup* group) override;
 };
 
+// Default instantiation. Unlimited seats, all devices, haptics, static callbacks, single threaded and cout logging.
+typedef BasicControllerManager<> ControllerManager;
+
+// Instantiated once in ControllerManager.cpp
+extern template class BasicControllerManager<>;
+
 #endif
\ No newline at end of file
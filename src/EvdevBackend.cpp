@@ -0,0 +1,772 @@
+#include "EvdevBackend.h"
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Max number of epoll events handled at once
+#define EVDEV_EPOLL_BATCH 16
+
+// Older headers don't have time accessors of input_event
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+// Bit test on ioctl bit array
+static const bool testBit(const unsigned long* bits, const int bit)
+{
+	const int bitsPerLong = sizeof(unsigned long) * 8;
+	return (bits[bit / bitsPerLong] >> (bit % bitsPerLong)) & 1UL;
+}
+
+EvdevBackend::EvdevBackend(InputTarget* manager)
+	: manager(manager),
+	epollFD(-1)
+{
+}
+
+EvdevBackend::~EvdevBackend()
+{
+	close();
+}
+
+const bool EvdevBackend::initEpoll()
+{
+	if (epollFD < 0)
+	{
+		epollFD = epoll_create1(EPOLL_CLOEXEC);
+	}
+
+	return epollFD >= 0;
+}
+
+const int EvdevBackend::open()
+{
+	if (!initEpoll())
+	{
+		return -1;
+	}
+
+	DIR* dir = opendir("/dev/input");
+	if (dir == nullptr)
+	{
+		return 0;
+	}
+
+	int opened = 0;
+
+	struct dirent* entry = nullptr;
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		if (strncmp(entry->d_name, "event", 5) != 0)
+		{
+			continue;
+		}
+
+		const std::string path = std::string("/dev/input/") + entry->d_name;
+
+		// Already opened
+		bool exists = false;
+		for (auto device : devices)
+		{
+			if (device->path == path)
+			{
+				exists = true;
+				break;
+			}
+		}
+
+		if (exists)
+		{
+			continue;
+		}
+
+		Device* device = openDevice(path);
+		if (device == nullptr)
+		{
+			continue;
+		}
+
+		char name[256] = { 0 };
+		if (ioctl(device->fd, EVIOCGNAME(sizeof(name) - 1), name) < 0)
+		{
+			name[0] = '\0';
+		}
+
+		if (registerDevice(manager, device, name))
+		{
+			opened++;
+		}
+	}
+
+	closedir(dir);
+
+	return opened;
+}
+
+EvdevBackend::Device* EvdevBackend::openDevice(const std::string& path)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+	{
+		// No permission or device is gone
+		return nullptr;
+	}
+
+	// Only gamepads. Keyboards, mice and touchpads are ignored.
+	unsigned long keyBits[(KEY_MAX + 1) / (sizeof(unsigned long) * 8) + 1] = { 0 };
+	if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0 || !testBit(keyBits, BTN_GAMEPAD))
+	{
+		::close(fd);
+		return nullptr;
+	}
+
+	Device* device = createDevice(fd);
+	device->path = path;
+	readDeviceID(device);
+
+	for (int code = 0; code <= ABS_RZ; code++)
+	{
+		struct input_absinfo info;
+		if (ioctl(fd, EVIOCGABS(code), &info) == 0 && info.maximum > info.minimum)
+		{
+			device->ranges[code].min = info.minimum;
+			device->ranges[code].max = info.maximum;
+		}
+	}
+
+	return device;
+}
+
+EvdevBackend::Device* EvdevBackend::createDevice(const int fd)
+{
+	Device* device = new Device();
+	device->fd = fd;
+	device->id = -1;
+	device->vendor = 0;
+	device->product = 0;
+	device->claimed = false;
+	device->hatX = 0;
+	device->hatY = 0;
+	device->dropped = false;
+	device->pendingSize = 0;
+	device->recordingPosition = 0;
+	device->recordingStart = 0;
+
+	// Xbox 360 pad ranges (xpad driver)
+	for (int code = 0; code <= ABS_RZ; code++)
+	{
+		device->ranges[code].min = (code == ABS_Z || code == ABS_RZ) ? 0 : -32768;
+		device->ranges[code].max = (code == ABS_Z || code == ABS_RZ) ? 255 : 32767;
+	}
+
+	return device;
+}
+
+const bool EvdevBackend::readDeviceID(Device* device)
+{
+	struct input_id id;
+	if (ioctl(device->fd, EVIOCGID, &id) < 0)
+	{
+		return false;
+	}
+
+	device->vendor = id.vendor;
+	device->product = id.product;
+	device->claimed = true;
+
+	return true;
+}
+
+const ControllerID EvdevBackend::addDevice(const int fd, const std::string& name)
+{
+	if (fd < 0 || !initEpoll())
+	{
+		return -1;
+	}
+
+	const int flags = fcntl(fd, F_GETFL, 0);
+	if (flags >= 0)
+	{
+		fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	}
+
+	Device* device = createDevice(fd);
+	readDeviceID(device);
+
+	if (!registerDevice(manager, device, name))
+	{
+		return -1;
+	}
+
+	return device->id;
+}
+
+const ControllerID EvdevBackend::addRecording(const std::string& path, const std::string& name)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open() || !initEpoll())
+	{
+		return -1;
+	}
+
+	std::vector<struct input_event> recording;
+
+	struct input_event ev;
+	while (file.read(reinterpret_cast<char*>(&ev), sizeof(ev)))
+	{
+		recording.push_back(ev);
+	}
+
+	if (recording.empty())
+	{
+		return -1;
+	}
+
+	const ControllerID id = manager->addExternalController(name);
+	if (id < 0)
+	{
+		return -1;
+	}
+
+	Device* device = createDevice(-1);
+	device->path = path;
+	device->id = id;
+	device->recording.swap(recording);
+	device->recordingStart = SDL_GetTicks();
+	devices.push_back(device);
+
+	return id;
+}
+
+const bool EvdevBackend::registerDevice(InputTarget* manager, Device* device, const std::string& name)
+{
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = device;
+
+	if (epoll_ctl(epollFD, EPOLL_CTL_ADD, device->fd, &ev) < 0)
+	{
+		::close(device->fd);
+		delete device;
+		return false;
+	}
+
+	// Remove SDL's copy of this pad before it's reported as external controller
+	if (device->claimed)
+	{
+		manager->claimDevice(device->vendor, device->product);
+	}
+
+	device->id = manager->addExternalController(name);
+	if (device->id < 0)
+	{
+		// No free external controller id
+		if (device->claimed)
+		{
+			manager->releaseDevice(device->vendor, device->product);
+		}
+
+		epoll_ctl(epollFD, EPOLL_CTL_DEL, device->fd, nullptr);
+		::close(device->fd);
+		delete device;
+		return false;
+	}
+
+	devices.push_back(device);
+
+	return true;
+}
+
+EvdevBackend::Device* EvdevBackend::findDevice(const ControllerID id)
+{
+	for (auto device : devices)
+	{
+		if (device->id == id)
+		{
+			return device;
+		}
+	}
+
+	return nullptr;
+}
+
+void EvdevBackend::removeDevice(const ControllerID id)
+{
+	Device* device = findDevice(id);
+	if (device != nullptr)
+	{
+		closeDevice(manager, device);
+	}
+}
+
+void EvdevBackend::closeDevice(InputTarget* manager, Device* device)
+{
+	for (auto it = devices.begin(); it != devices.end(); ++it)
+	{
+		if (*it == device)
+		{
+			devices.erase(it);
+			break;
+		}
+	}
+
+	// Recording has no fd
+	if (device->fd >= 0)
+	{
+		if (epollFD >= 0)
+		{
+			epoll_ctl(epollFD, EPOLL_CTL_DEL, device->fd, nullptr);
+		}
+
+		::close(device->fd);
+	}
+
+	manager->removeExternalController(device->id);
+
+	// SDL may report pad again (e.g. backend closed but pad still plugged in)
+	if (device->claimed)
+	{
+		manager->releaseDevice(device->vendor, device->product);
+	}
+
+	delete device;
+}
+
+void EvdevBackend::close()
+{
+	while (!devices.empty())
+	{
+		closeDevice(manager, devices.back());
+	}
+
+	if (epollFD >= 0)
+	{
+		::close(epollFD);
+		epollFD = -1;
+	}
+}
+
+const int EvdevBackend::getDeviceCount() const
+{
+	return static_cast<int>(devices.size());
+}
+
+const bool EvdevBackend::wait(const int timeout)
+{
+	if (epollFD < 0 || devices.empty())
+	{
+		return false;
+	}
+
+	struct epoll_event events[EVDEV_EPOLL_BATCH];
+	int count = 0;
+	do
+	{
+		count = epoll_wait(epollFD, events, EVDEV_EPOLL_BATCH, timeout);
+	} while (count < 0 && errno == EINTR);
+
+	return count > 0;
+}
+
+void EvdevBackend::pollInput(InputTarget* manager)
+{
+	if (epollFD < 0 || devices.empty())
+	{
+		return;
+	}
+
+	struct epoll_event events[EVDEV_EPOLL_BATCH];
+
+	int count = EVDEV_EPOLL_BATCH;
+	while (count == EVDEV_EPOLL_BATCH)
+	{
+		count = epoll_wait(epollFD, events, EVDEV_EPOLL_BATCH, 0);
+
+		for (int i = 0; i < count; i++)
+		{
+			Device* device = static_cast<Device*>(events[i].data.ptr);
+
+			// Read even on hang up. Last events may still be buffered.
+			const bool alive = readDevice(manager, device);
+
+			if (!alive || (events[i].events & (EPOLLHUP | EPOLLERR)) != 0)
+			{
+				closeDevice(manager, device);
+			}
+		}
+	}
+
+	// Recordings aren't in epoll set
+	size_t index = 0;
+	while (index < devices.size())
+	{
+		Device* device = devices[index];
+		if (device->fd < 0 && !advanceRecording(manager, device))
+		{
+			// Finished. Removed from devices.
+			closeDevice(manager, device);
+		}
+		else
+		{
+			index++;
+		}
+	}
+}
+
+const int EvdevBackend::getWaitFD()
+{
+	return epollFD;
+}
+
+const int EvdevBackend::getWaitTimeout()
+{
+	int timeout = -1;
+	const Uint32 now = SDL_GetTicks();
+
+	for (auto device : devices)
+	{
+		if (device->fd >= 0 || device->recordingPosition >= device->recording.size())
+		{
+			continue;
+		}
+
+		const Uint32 due = device->recordingStart + getRecordingOffset(device, device->recordingPosition);
+		const Sint32 remaining = static_cast<Sint32>(due - now);
+		const int deviceTimeout = (remaining > 0) ? remaining : 0;
+
+		if (timeout < 0 || deviceTimeout < timeout)
+		{
+			timeout = deviceTimeout;
+		}
+	}
+
+	return timeout;
+}
+
+const bool EvdevBackend::advanceRecording(InputTarget* manager, Device* device)
+{
+	const Uint32 elapsed = SDL_GetTicks() - device->recordingStart;
+
+	while (device->recordingPosition < device->recording.size() && getRecordingOffset(device, device->recordingPosition) <= elapsed)
+	{
+		handleInput(manager, device, device->recording[device->recordingPosition]);
+		device->recordingPosition++;
+	}
+
+	return device->recordingPosition < device->recording.size();
+}
+
+const Uint32 EvdevBackend::getRecordingOffset(const Device* device, const size_t index) const
+{
+	const struct input_event& first = device->recording.front();
+	const struct input_event& ev = device->recording[index];
+
+	const long long microseconds = static_cast<long long>(ev.input_event_sec - first.input_event_sec) * 1000000LL + (ev.input_event_usec - first.input_event_usec);
+	return (microseconds > 0) ? static_cast<Uint32>(microseconds / 1000) : 0;
+}
+
+const bool EvdevBackend::readDevice(InputTarget* manager, Device* device)
+{
+	const size_t eventSize = sizeof(struct input_event);
+	unsigned char buffer[sizeof(struct input_event) * EVDEV_READ_BATCH];
+
+	while (true)
+	{
+		// Prepend partial event left from last read
+		memcpy(buffer, device->pending, device->pendingSize);
+
+		const ssize_t size = read(device->fd, buffer + device->pendingSize, sizeof(buffer) - device->pendingSize);
+
+		if (size < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			// EAGAIN means drained. Anything else (ENODEV) means unplugged.
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		else if (size == 0)
+		{
+			// Writer closed
+			return false;
+		}
+
+		const size_t total = device->pendingSize + static_cast<size_t>(size);
+		const size_t count = total / eventSize;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			struct input_event ev;
+			memcpy(&ev, buffer + i * eventSize, eventSize);
+			handleInput(manager, device, ev);
+		}
+
+		device->pendingSize = total - count * eventSize;
+		memcpy(device->pending, buffer + count * eventSize, device->pendingSize);
+	}
+}
+
+void EvdevBackend::handleInput(InputTarget* manager, Device* device, const struct input_event& ev)
+{
+	if (ev.type == EV_SYN)
+	{
+		if (ev.code == SYN_DROPPED)
+		{
+			// Kernel buffer overflowed. Events until next SYN_REPORT are incomplete.
+			device->dropped = true;
+		}
+		else if (ev.code == SYN_REPORT && device->dropped)
+		{
+			device->dropped = false;
+			resync(manager, device);
+		}
+
+		return;
+	}
+
+	if (device->dropped)
+	{
+		return;
+	}
+
+	if (ev.type == EV_KEY)
+	{
+		handleKey(manager, device, ev.code, ev.value);
+	}
+	else if (ev.type == EV_ABS)
+	{
+		handleAbs(manager, device, ev.code, ev.value);
+	}
+}
+
+void EvdevBackend::handleKey(InputTarget* manager, Device* device, const int code, const int value)
+{
+	// Ignore autorepeat
+	if (value == 2)
+	{
+		return;
+	}
+
+	IO::XBOX_360::BUTTON button = IO::XBOX_360::BUTTON::NONE;
+
+	switch (code)
+	{
+	case BTN_A:
+		button = IO::XBOX_360::BUTTON::A;
+		break;
+	case BTN_B:
+		button = IO::XBOX_360::BUTTON::B;
+		break;
+	case BTN_X:
+		button = IO::XBOX_360::BUTTON::X;
+		break;
+	case BTN_Y:
+		button = IO::XBOX_360::BUTTON::Y;
+		break;
+	case BTN_SELECT:
+		button = IO::XBOX_360::BUTTON::BACK;
+		break;
+	case BTN_START:
+		button = IO::XBOX_360::BUTTON::START;
+		break;
+	case BTN_THUMBL:
+		button = IO::XBOX_360::BUTTON::L3;
+		break;
+	case BTN_THUMBR:
+		button = IO::XBOX_360::BUTTON::R3;
+		break;
+	case BTN_TL:
+		button = IO::XBOX_360::BUTTON::LS;
+		break;
+	case BTN_TR:
+		button = IO::XBOX_360::BUTTON::RS;
+		break;
+	case BTN_DPAD_UP:
+		button = IO::XBOX_360::BUTTON::DPAD_UP;
+		break;
+	case BTN_DPAD_DOWN:
+		button = IO::XBOX_360::BUTTON::DPAD_DOWN;
+		break;
+	case BTN_DPAD_LEFT:
+		button = IO::XBOX_360::BUTTON::DPAD_LEFT;
+		break;
+	case BTN_DPAD_RIGHT:
+		button = IO::XBOX_360::BUTTON::DPAD_RIGHT;
+		break;
+	default:
+		// Guide button and unknown keys
+		return;
+	}
+
+	injectButton(manager, device, button, value != 0);
+}
+
+void EvdevBackend::handleAbs(InputTarget* manager, Device* device, const int code, const int value)
+{
+	switch (code)
+	{
+	case ABS_X:
+		injectAxis(manager, device, IO::XBOX_360::AXIS::L_AXIS_X, scaleAxis(device, code, value));
+		break;
+	case ABS_Y:
+		injectAxis(manager, device, IO::XBOX_360::AXIS::L_AXIS_Y, scaleAxis(device, code, value));
+		break;
+	case ABS_RX:
+		injectAxis(manager, device, IO::XBOX_360::AXIS::R_AXIS_X, scaleAxis(device, code, value));
+		break;
+	case ABS_RY:
+		injectAxis(manager, device, IO::XBOX_360::AXIS::R_AXIS_Y, scaleAxis(device, code, value));
+		break;
+	case ABS_Z:
+		injectAxis(manager, device, IO::XBOX_360::AXIS::LT, scaleAxis(device, code, value));
+		break;
+	case ABS_RZ:
+		injectAxis(manager, device, IO::XBOX_360::AXIS::RT, scaleAxis(device, code, value));
+		break;
+	case ABS_HAT0X:
+		handleHat(manager, device, device->hatX, value, IO::XBOX_360::BUTTON::DPAD_LEFT, IO::XBOX_360::BUTTON::DPAD_RIGHT);
+		break;
+	case ABS_HAT0Y:
+		handleHat(manager, device, device->hatY, value, IO::XBOX_360::BUTTON::DPAD_UP, IO::XBOX_360::BUTTON::DPAD_DOWN);
+		break;
+	default:
+		break;
+	}
+}
+
+void EvdevBackend::handleHat(InputTarget* manager, Device* device, int& last, const int value, const IO::XBOX_360::BUTTON negative, const IO::XBOX_360::BUTTON positive)
+{
+	const int direction = (value > 0) ? 1 : ((value < 0) ? -1 : 0);
+	if (direction == last)
+	{
+		return;
+	}
+
+	// Release old direction first
+	if (last < 0)
+	{
+		injectButton(manager, device, negative, false);
+	}
+	else if (last > 0)
+	{
+		injectButton(manager, device, positive, false);
+	}
+
+	if (direction < 0)
+	{
+		injectButton(manager, device, negative, true);
+	}
+	else if (direction > 0)
+	{
+		injectButton(manager, device, positive, true);
+	}
+
+	last = direction;
+}
+
+void EvdevBackend::resync(InputTarget* manager, Device* device)
+{
+	unsigned long keyBits[(KEY_MAX + 1) / (sizeof(unsigned long) * 8) + 1] = { 0 };
+	if (ioctl(device->fd, EVIOCGKEY(sizeof(keyBits)), keyBits) >= 0)
+	{
+		const int keys[] = { BTN_A, BTN_B, BTN_X, BTN_Y, BTN_SELECT, BTN_START, BTN_THUMBL, BTN_THUMBR, BTN_TL, BTN_TR, BTN_DPAD_UP, BTN_DPAD_DOWN, BTN_DPAD_LEFT, BTN_DPAD_RIGHT };
+		const IO::XBOX_360::BUTTON buttons[] =
+		{
+			IO::XBOX_360::BUTTON::A, IO::XBOX_360::BUTTON::B, IO::XBOX_360::BUTTON::X, IO::XBOX_360::BUTTON::Y,
+			IO::XBOX_360::BUTTON::BACK, IO::XBOX_360::BUTTON::START, IO::XBOX_360::BUTTON::L3, IO::XBOX_360::BUTTON::R3,
+			IO::XBOX_360::BUTTON::LS, IO::XBOX_360::BUTTON::RS, IO::XBOX_360::BUTTON::DPAD_UP, IO::XBOX_360::BUTTON::DPAD_DOWN,
+			IO::XBOX_360::BUTTON::DPAD_LEFT, IO::XBOX_360::BUTTON::DPAD_RIGHT
+		};
+
+		for (int i = 0; i < static_cast<int>(sizeof(keys) / sizeof(keys[0])); i++)
+		{
+			// Only report buttons that changed while events were dropped
+			const bool pressed = testBit(keyBits, keys[i]);
+			if (manager->isButtonPressed(device->id, buttons[i]) != pressed)
+			{
+				handleKey(manager, device, keys[i], pressed ? 1 : 0);
+			}
+		}
+	}
+
+	const int axes[] = { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ, ABS_HAT0X, ABS_HAT0Y };
+	for (const int axis : axes)
+	{
+		struct input_absinfo info;
+		if (ioctl(device->fd, EVIOCGABS(axis), &info) == 0)
+		{
+			handleAbs(manager, device, axis, info.value);
+		}
+	}
+}
+
+const Sint16 EvdevBackend::scaleAxis(const Device* device, const int code, const int value)
+{
+	const AxisRange& range = device->ranges[code];
+	const int span = range.max - range.min;
+	if (span <= 0)
+	{
+		return 0;
+	}
+
+	int clamped = value;
+	if (clamped < range.min)
+	{
+		clamped = range.min;
+	}
+	else if (clamped > range.max)
+	{
+		clamped = range.max;
+	}
+
+	const long long offset = static_cast<long long>(clamped - range.min);
+
+	if (code == ABS_Z || code == ABS_RZ)
+	{
+		// Triggers are 0 ~ 32767 in SDL
+		return static_cast<Sint16>(offset * 32767 / span);
+	}
+
+	// Sticks are -32768 ~ 32767. Y is already down positive in both.
+	return static_cast<Sint16>(offset * 65535 / span - 32768);
+}
+
+void EvdevBackend::injectButton(InputTarget* manager, Device* device, const IO::XBOX_360::BUTTON button, const bool pressed)
+{
+	SDL_Event e;
+	memset(&e, 0, sizeof(e));
+	e.type = pressed ? SDL_CONTROLLERBUTTONDOWN : SDL_CONTROLLERBUTTONUP;
+	e.cbutton.timestamp = SDL_GetTicks();
+	e.cbutton.which = device->id;
+	e.cbutton.button = static_cast<Uint8>(button);
+	e.cbutton.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+
+	manager->injectEvent(e);
+}
+
+void EvdevBackend::injectAxis(InputTarget* manager, Device* device, const IO::XBOX_360::AXIS axis, const Sint16 value)
+{
+	SDL_Event e;
+	memset(&e, 0, sizeof(e));
+	e.type = SDL_CONTROLLERAXISMOTION;
+	e.caxis.timestamp = SDL_GetTicks();
+	e.caxis.which = device->id;
+	e.caxis.axis = static_cast<Uint8>(axis);
+	e.caxis.value = value;
+
+	manager->injectEvent(e);
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef EVDEV_BACKEND_H
+#define EVDEV_BACKEND_H
+
+#if defined(__linux__)
+
+#include "ControllerManager.h"
+
+#include <linux/input.h>
+
+// Max number of input_event read from device at once
+#define EVDEV_READ_BATCH 64
+
+/**
+*	@class EvdevBackend
+*
+*	@brief Reads gamepads directly from Linux evdev nodes (/dev/input/event*).
+*
+*	Skips SDL event queue entirely. Every device fd is registered to single epoll instance,
+*	so update() only costs one epoll_wait when nothing happened. Ready devices are drained
+*	with bulk read of EVDEV_READ_BATCH events at a time.
+*
+*	Devices are reported as external controllers (see ControllerManager::addExternalController)
+*	and input is translated to xbox 360 layout, so callbacks and queries work same as SDL controllers.
+*
+*	Needs read permission on /dev/input/event* (usually input group).
+*	Opened devices are claimed by vendor/product (see ControllerManager::claimDevice), so SDL doesn't report
+*	same pads again. Other SDL devices, including generic joysticks, are unaffected.
+*	While model is claimed, newly plugged pad of that model shows up only when open() is called again.
+*
+*	EvdevBackend backend(ControllerManager::getInstance());
+*	backend.open();
+*	ControllerManager::getInstance()->addInputSource(&backend);
+*
+*	Any instantiation of BasicControllerManager can be given, since backend only uses InputTarget.
+*	Close (or destroy) backend before ControllerManager::deleteInstance().
+*	Events are injected on update() thread, so fast path listeners see them at that time, not earlier.
+*/
+class EvdevBackend : public InputSource
+{
+private:
+	struct AxisRange
+	{
+		int min;
+		int max;
+	};
+
+	struct Device
+	{
+		int fd;
+		std::string path;
+		ControllerID id;
+
+		// From EVIOCGID. claimed is true if device is claimed from SDL.
+		Uint16 vendor;
+		Uint16 product;
+		bool claimed;
+
+		// Range of ABS_X ~ ABS_RZ
+		AxisRange ranges[ABS_RZ + 1];
+
+		// Last dpad hat value (-1, 0, 1)
+		int hatX;
+		int hatY;
+
+		// True after SYN_DROPPED until next SYN_REPORT
+		bool dropped;
+
+		// Partial input_event left from last read
+		unsigned char pending[sizeof(struct input_event)];
+		size_t pendingSize;
+
+		// Recorded events replayed by time. fd is -1 for recording.
+		std::vector<struct input_event> recording;
+		size_t recordingPosition;
+		Uint32 recordingStart;
+	};
+
+	// Manager this backend feeds
+	InputTarget* manager;
+
+	int epollFD;
+	std::vector<Device*> devices;
+
+	Device* findDevice(const ControllerID id);
+
+	// New device with default state and xbox 360 ranges
+	static Device* createDevice(const int fd);
+
+	// Open device node. Returns nullptr if it isn't a gamepad.
+	Device* openDevice(const std::string& path);
+
+	// Read vendor/product of evdev fd. Returns false if fd isn't evdev node.
+	static const bool readDeviceID(Device* device);
+
+	// Register device to epoll and manager, and claim it from SDL. Closes device on fail.
+	const bool registerDevice(InputTarget* manager, Device* device, const std::string& name);
+
+	// Read all pending events of device. Returns false if device is gone.
+	const bool readDevice(InputTarget* manager, Device* device);
+
+	// Translate single event
+	void handleInput(InputTarget* manager, Device* device, const struct input_event& ev);
+
+	// Translate key event
+	void handleKey(InputTarget* manager, Device* device, const int code, const int value);
+
+	// Translate abs event
+	void handleAbs(InputTarget* manager, Device* device, const int code, const int value);
+
+	// Press/release dpad button pair from hat value
+	void handleHat(InputTarget* manager, Device* device, int& last, const int value, const IO::XBOX_360::BUTTON negative, const IO::XBOX_360::BUTTON positive);
+
+	// Re-read whole device state after SYN_DROPPED
+	void resync(InputTarget* manager, Device* device);
+
+	void injectButton(InputTarget* manager, Device* device, const IO::XBOX_360::BUTTON button, const bool pressed);
+	void injectAxis(InputTarget* manager, Device* device, const IO::XBOX_360::AXIS axis, const Sint16 value);
+
+	// Scale raw value to SDL axis range
+	const Sint16 scaleAxis(const Device* device, const int code, const int value);
+
+	void closeDevice(InputTarget* manager, Device* device);
+
+	// Feed recorded events that are due. Returns false when recording is finished.
+	const bool advanceRecording(InputTarget* manager, Device* device);
+
+	// Milliseconds from first recorded event to event at index
+	const Uint32 getRecordingOffset(const Device* device, const size_t index) const;
+
+	// Create epoll instance if there isn't
+	const bool initEpoll();
+public:
+	// Devices are reported to manager. Add backend to same manager with addInputSource.
+	explicit EvdevBackend(InputTarget* manager);
+	~EvdevBackend();
+
+	// Disable copy
+	EvdevBackend(EvdevBackend const&) = delete;
+	void operator=(EvdevBackend const&) = delete;
+
+	/**
+	*	Open all gamepad nodes under /dev/input. Can be called again to pick up new devices.
+	*	@return Number of newly opened devices. -1 if epoll can't be created.
+	*/
+	const int open();
+
+	/**
+	*	Add already opened evdev compatible fd. Backend owns fd afterwards.
+	*	Live stream of input_event (e.g. pipe) works too. Default xbox 360 ranges are assumed.
+	*	Fd of evdev node is claimed from SDL like open() does. Streams aren't.
+	*	@return Controller id. -1 if fail.
+	*/
+	const ControllerID addDevice(const int fd, const std::string& name);
+
+	/**
+	*	Replay recorded input as controller. Events are fed with their original timing, then controller is disconnected.
+	*	Record with e.g. cat /dev/input/event5 > pad.bin. Default xbox 360 ranges are assumed.
+	*	@return Controller id. -1 if file can't be read or has no events.
+	*/
+	const ControllerID addRecording(const std::string& path, const std::string& name);
+
+	// Close device and remove its controller
+	void removeDevice(const ControllerID id);
+
+	// Close all devices
+	void close();
+
+	// Number of opened devices
+	const int getDeviceCount() const;
+
+	/**
+	*	Wait until any device becomes readable. Doesn't read.
+	*	@param timeout Milliseconds. -1 to wait forever.
+	*	@return True if any device is readable.
+	*/
+	const bool wait(const int timeout);
+
+	// Read and dispatch all ready events. Called by ControllerManager::update() once added as input source.
+	void pollInput(InputTarget* manager) override;
+
+	// Epoll fd, so ControllerManager::waitForInput wakes up on device input
+	const int getWaitFD() override;
+
+	// Time until next recorded event is due
+	const int getWaitTimeout() override;
+};
+
+#endif
+
+#endif
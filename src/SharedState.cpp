@@ -0,0 +1,397 @@
+#include "SharedState.h"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#define SHARED_STATE_POSIX
+#endif
+
+static_assert(sizeof(SharedControllerState) == 64, "SharedControllerState layout changed");
+static_assert(sizeof(SharedStateHeader) == 64, "SharedStateHeader layout changed");
+static_assert(sizeof(SharedStateSlot) == sizeof(SharedControllerState), "SharedStateSlot layout changed");
+static_assert(sizeof(std::atomic<Uint32>) == sizeof(Uint32), "Atomic words must be plain 32 bit");
+
+// Initial sequence. Even, and never 0 so read() can use 0 as failure.
+static const Uint32 INITIAL_SEQUENCE = 2;
+
+static std::string segmentName(const std::string& name)
+{
+	return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+// Copy slot between local form and segment words. Relaxed, ordered by seqlock fences.
+static void storeSlot(SharedStateSlot& slot, const SharedControllerState& state)
+{
+	Uint32 words[SHARED_STATE_SLOT_WORDS];
+	memcpy(words, &state, sizeof(words));
+
+	for (size_t i = 0; i < SHARED_STATE_SLOT_WORDS; i++)
+	{
+		slot.words[i].store(words[i], std::memory_order_relaxed);
+	}
+}
+
+static void loadSlot(const SharedStateSlot& slot, SharedControllerState& state)
+{
+	Uint32 words[SHARED_STATE_SLOT_WORDS];
+
+	for (size_t i = 0; i < SHARED_STATE_SLOT_WORDS; i++)
+	{
+		words[i] = slot.words[i].load(std::memory_order_relaxed);
+	}
+
+	memcpy(&state, words, sizeof(words));
+}
+
+SharedStateWriter::SharedStateWriter()
+	: fd(-1),
+	layout(nullptr),
+	dirtySlots(0)
+{
+}
+
+SharedStateWriter::~SharedStateWriter()
+{
+	close();
+}
+
+const bool SharedStateWriter::open(const std::string& name)
+{
+	close();
+
+#if defined(SHARED_STATE_POSIX)
+	const std::string path = segmentName(name);
+
+	fd = createSegment(path);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	if (ftruncate(fd, sizeof(SharedStateLayout)) != 0)
+	{
+		::close(fd);
+		fd = -1;
+		shm_unlink(path.c_str());
+		return false;
+	}
+
+	void* memory = mmap(nullptr, sizeof(SharedStateLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (memory == MAP_FAILED)
+	{
+		::close(fd);
+		fd = -1;
+		shm_unlink(path.c_str());
+		return false;
+	}
+
+	this->name = path;
+	layout = static_cast<SharedStateLayout*>(memory);
+
+	// Segment is new, but don't let readers trust header until it's complete
+	layout->header.magic.store(0, std::memory_order_relaxed);
+
+	layout->header.version = SHARED_STATE_VERSION;
+	layout->header.headerSize = sizeof(SharedStateHeader);
+	layout->header.entrySize = sizeof(SharedControllerState);
+	layout->header.capacity = SHARED_STATE_CAPACITY;
+	layout->header.writerPID = static_cast<Uint32>(getpid());
+	layout->header.publishTicks.store(SDL_GetTicks(), std::memory_order_relaxed);
+	memset(layout->header.reserved, 0, sizeof(layout->header.reserved));
+
+	for (int i = 0; i < SHARED_STATE_CAPACITY; i++)
+	{
+		memset(&slots[i], 0, sizeof(SharedControllerState));
+		slots[i].id = -1;
+		storeSlot(layout->controllers[i], slots[i]);
+	}
+
+	dirtySlots = 0;
+
+	layout->header.sequence.store(INITIAL_SEQUENCE, std::memory_order_relaxed);
+	layout->header.magic.store(SHARED_STATE_MAGIC, std::memory_order_release);
+
+	return true;
+#else
+	(void)name;
+	return false;
+#endif
+}
+
+const int SharedStateWriter::createSegment(const std::string& path)
+{
+#if defined(SHARED_STATE_POSIX)
+	int segment = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (segment >= 0 || errno != EEXIST)
+	{
+		return segment;
+	}
+
+	// Segment exists. Take over only if writer that created it is gone (e.g. crashed without unlinking).
+	const int existing = shm_open(path.c_str(), O_RDONLY, 0);
+	if (existing < 0)
+	{
+		return -1;
+	}
+
+	bool writerAlive = true;
+
+	struct stat info;
+	if (fstat(existing, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedStateHeader))
+	{
+		void* memory = mmap(nullptr, sizeof(SharedStateHeader), PROT_READ, MAP_SHARED, existing, 0);
+		if (memory != MAP_FAILED)
+		{
+			const SharedStateHeader* header = static_cast<const SharedStateHeader*>(memory);
+			if (header->magic.load(std::memory_order_acquire) == SHARED_STATE_MAGIC)
+			{
+				const pid_t pid = static_cast<pid_t>(header->writerPID);
+				writerAlive = (pid > 0) && (kill(pid, 0) == 0 || errno == EPERM);
+			}
+			munmap(memory, sizeof(SharedStateHeader));
+		}
+	}
+
+	::close(existing);
+
+	if (writerAlive)
+	{
+		// Other writer owns this name
+		return -1;
+	}
+
+	shm_unlink(path.c_str());
+	return shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+#else
+	(void)path;
+	return -1;
+#endif
+}
+
+void SharedStateWriter::close()
+{
+#if defined(SHARED_STATE_POSIX)
+	if (layout != nullptr)
+	{
+		munmap(layout, sizeof(SharedStateLayout));
+		layout = nullptr;
+	}
+
+	if (fd >= 0)
+	{
+		::close(fd);
+		fd = -1;
+		shm_unlink(name.c_str());
+	}
+#endif
+}
+
+const bool SharedStateWriter::isOpen() const
+{
+	return layout != nullptr;
+}
+
+void SharedStateWriter::beginWrite()
+{
+	const Uint32 sequence = layout->header.sequence.load(std::memory_order_relaxed);
+
+	// Odd. Slot writes below must not become visible before this.
+	layout->header.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	dirtySlots = 0;
+}
+
+void SharedStateWriter::endWrite()
+{
+	for (int i = 0; i < SHARED_STATE_CAPACITY; i++)
+	{
+		if (dirtySlots & (1u << i))
+		{
+			storeSlot(layout->controllers[i], slots[i]);
+		}
+	}
+
+	dirtySlots = 0;
+
+	layout->header.publishTicks.store(SDL_GetTicks(), std::memory_order_relaxed);
+
+	// Even again. Publishes slot writes.
+	layout->header.sequence.store(layout->header.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+const Uint32 SharedStateWriter::getSequence() const
+{
+	// Odd while writing, so +1 is value endWrite will store
+	const Uint32 sequence = layout->header.sequence.load(std::memory_order_relaxed);
+	return (sequence & 1) ? sequence + 1 : sequence;
+}
+
+SharedControllerState* SharedStateWriter::getSlot(const Sint32 id, const bool create)
+{
+	SharedControllerState* empty = nullptr;
+	SharedControllerState* disconnected = nullptr;
+
+	for (int i = 0; i < SHARED_STATE_CAPACITY; i++)
+	{
+		SharedControllerState& slot = slots[i];
+
+		if (slot.id == id)
+		{
+			// Caller is about to change it
+			dirtySlots |= (1u << i);
+			return &slot;
+		}
+		else if (slot.id < 0)
+		{
+			if (empty == nullptr)
+			{
+				empty = &slot;
+			}
+		}
+		else if ((slot.flags & SHARED_STATE_CONNECTED) == 0 && disconnected == nullptr)
+		{
+			disconnected = &slot;
+		}
+	}
+
+	if (!create)
+	{
+		return nullptr;
+	}
+
+	// Keep last state of disconnected controllers as long as possible
+	SharedControllerState* slot = (empty != nullptr) ? empty : disconnected;
+	if (slot != nullptr)
+	{
+		memset(slot, 0, sizeof(SharedControllerState));
+		slot->id = id;
+		dirtySlots |= (1u << static_cast<int>(slot - slots));
+	}
+
+	return slot;
+}
+
+SharedStateReader::SharedStateReader()
+	: fd(-1),
+	layout(nullptr)
+{
+}
+
+SharedStateReader::~SharedStateReader()
+{
+	close();
+}
+
+const bool SharedStateReader::open(const std::string& name)
+{
+	close();
+
+#if defined(SHARED_STATE_POSIX)
+	fd = shm_open(segmentName(name).c_str(), O_RDONLY, 0);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedStateLayout))
+	{
+		close();
+		return false;
+	}
+
+	void* memory = mmap(nullptr, sizeof(SharedStateLayout), PROT_READ, MAP_SHARED, fd, 0);
+	if (memory == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	layout = static_cast<const SharedStateLayout*>(memory);
+
+	const SharedStateHeader& header = layout->header;
+	if (header.magic.load(std::memory_order_acquire) != SHARED_STATE_MAGIC || header.version != SHARED_STATE_VERSION || header.headerSize != sizeof(SharedStateHeader)
+		|| header.entrySize != sizeof(SharedControllerState) || header.capacity != SHARED_STATE_CAPACITY)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+#else
+	(void)name;
+	return false;
+#endif
+}
+
+void SharedStateReader::close()
+{
+#if defined(SHARED_STATE_POSIX)
+	if (layout != nullptr)
+	{
+		munmap(const_cast<SharedStateLayout*>(layout), sizeof(SharedStateLayout));
+		layout = nullptr;
+	}
+
+	if (fd >= 0)
+	{
+		::close(fd);
+		fd = -1;
+	}
+#endif
+}
+
+const bool SharedStateReader::isOpen() const
+{
+	return layout != nullptr;
+}
+
+const Uint32 SharedStateReader::getSequence() const
+{
+	if (layout == nullptr)
+	{
+		return 0;
+	}
+
+	return layout->header.sequence.load(std::memory_order_acquire);
+}
+
+const Uint32 SharedStateReader::read(SharedControllerState* out, const int maxRetry) const
+{
+	if (layout == nullptr)
+	{
+		return 0;
+	}
+
+	for (int i = 0; i < maxRetry; i++)
+	{
+		const Uint32 before = layout->header.sequence.load(std::memory_order_acquire);
+		if (before & 1)
+		{
+			// Writer is in the middle of update
+			continue;
+		}
+
+		for (int slot = 0; slot < SHARED_STATE_CAPACITY; slot++)
+		{
+			loadSlot(layout->controllers[slot], out[slot]);
+		}
+
+		// Copy must complete before sequence is checked again
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const Uint32 after = layout->header.sequence.load(std::memory_order_relaxed);
+
+		if (before == after)
+		{
+			return before;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,180 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <atomic>
+#include <string>
+#include <SDL.h>
+
+// 'CMST'
+#define SHARED_STATE_MAGIC 0x54534D43
+// Bump when layout changes
+#define SHARED_STATE_VERSION 1
+// Number of controller slots in segment
+#define SHARED_STATE_CAPACITY 16
+// Number of axis values in slot. Game controllers use first 6 (IO::XBOX_360::AXIS)
+#define SHARED_STATE_AXIS_COUNT 8
+
+// Slot flags
+#define SHARED_STATE_CONNECTED 0x1
+#define SHARED_STATE_GAME_CONTROLLER 0x2
+
+/**
+*	State of single controller in shared memory. 64 bytes.
+*
+*	Game controller: bit n of buttons is IO::XBOX_360::BUTTON n (virtual buttons included), axes[n] is IO::XBOX_360::AXIS n.
+*	Generic joystick: buttons are first 64 joystick buttons followed by hat directions, axes are first 8 joystick axes.
+*	Slot keeps last state after disconnect (connected flag cleared) until another controller takes it.
+*	In segment, slot is stored as SharedStateSlot words. Use SharedStateReader to get this form.
+*/
+struct SharedControllerState
+{
+	// Controller id. -1 if slot was never used.
+	Sint32 id;
+	Uint32 flags;
+	Uint64 buttons;
+	float axes[SHARED_STATE_AXIS_COUNT];
+	// Header sequence when this slot was last written
+	Uint32 sequence;
+	Uint32 reserved[3];
+};
+
+// Number of 32 bit words in slot
+#define SHARED_STATE_SLOT_WORDS (sizeof(SharedControllerState) / sizeof(Uint32))
+
+/**
+*	Slot in segment.
+*	Stored as atomic words so seqlock reader and writer never race on plain memory.
+*/
+struct SharedStateSlot
+{
+	std::atomic<Uint32> words[SHARED_STATE_SLOT_WORDS];
+};
+
+/**
+*	Header of shared memory segment. 64 bytes.
+*
+*	sequence is seqlock counter for whole table. Odd while writer is updating.
+*	Reader must retry if sequence was odd or changed while copying.
+*	magic is written last when segment is created, so reader can trust header once it matches.
+*/
+struct SharedStateHeader
+{
+	std::atomic<Uint32> magic;
+	Uint32 version;
+	Uint32 headerSize;
+	Uint32 entrySize;
+	Uint32 capacity;
+	Uint32 writerPID;
+	std::atomic<Uint32> sequence;
+	// SDL_GetTicks of writer when table was last written
+	std::atomic<Uint32> publishTicks;
+	Uint32 reserved[8];
+};
+
+struct SharedStateLayout
+{
+	SharedStateHeader header;
+	SharedStateSlot controllers[SHARED_STATE_CAPACITY];
+};
+
+/**
+*	@class SharedStateWriter
+*
+*	@brief Owns POSIX shared memory segment and writes controller table into it.
+*
+*	Used by ControllerManager::enableSharedStateExport. Single writer per segment name.
+*	Slots are edited in local copy and copied to segment by endWrite.
+*	Not available (open fails) on platforms without shm_open.
+*/
+class SharedStateWriter
+{
+private:
+	int fd;
+	std::string name;
+	SharedStateLayout* layout;
+
+	// Local copy of slots and mask of slots changed since beginWrite
+	SharedControllerState slots[SHARED_STATE_CAPACITY];
+	Uint32 dirtySlots;
+
+	// Create segment exclusively. Takes over segment only if its writer process is gone.
+	const int createSegment(const std::string& path);
+public:
+	SharedStateWriter();
+	~SharedStateWriter();
+
+	// Disable copy
+	SharedStateWriter(SharedStateWriter const&) = delete;
+	void operator=(SharedStateWriter const&) = delete;
+
+	/**
+	*	Create segment. Name is prefixed with '/' if it isn't.
+	*	Fails if segment already exists and its writer is still running.
+	*/
+	const bool open(const std::string& name);
+
+	// Unmap and unlink segment
+	void close();
+
+	const bool isOpen() const;
+
+	// Seqlock write section. All slot writes must happen between these. endWrite copies changed slots to segment.
+	void beginWrite();
+	void endWrite();
+
+	/**
+	*	Get slot of controller.
+	*	@param create Take empty or disconnected slot if controller has none.
+	*	@return nullptr if not found or table is full.
+	*/
+	SharedControllerState* getSlot(const Sint32 id, const bool create);
+
+	// Sequence that becomes visible when current write ends
+	const Uint32 getSequence() const;
+};
+
+/**
+*	@class SharedStateReader
+*
+*	@brief Maps segment exported by other process read only.
+*
+*	SharedStateReader reader;
+*	if (reader.open("/controller_state"))
+*	{
+*		SharedControllerState states[SHARED_STATE_CAPACITY];
+*		reader.read(states);
+*	}
+*/
+class SharedStateReader
+{
+private:
+	int fd;
+	const SharedStateLayout* layout;
+public:
+	SharedStateReader();
+	~SharedStateReader();
+
+	// Disable copy
+	SharedStateReader(SharedStateReader const&) = delete;
+	void operator=(SharedStateReader const&) = delete;
+
+	// Map segment. Fails if it doesn't exist or layout version doesn't match.
+	const bool open(const std::string& name);
+
+	void close();
+
+	const bool isOpen() const;
+
+	// Current sequence. Cheap check whether anything changed since last read.
+	const Uint32 getSequence() const;
+
+	/**
+	*	Copy consistent snapshot of all slots.
+	*	@param out Array of SHARED_STATE_CAPACITY slots.
+	*	@param maxRetry Give up after this many torn reads.
+	*	@return Sequence of snapshot. 0 if not open or gave up.
+	*/
+	const Uint32 read(SharedControllerState* out, const int maxRetry = 1000) const;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "StickProcessor.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define STICK_PROCESSOR_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STICK_PROCESSOR_SSE
+#endif
+
+// Avoids division by zero when stick is centered
+static const float MIN_MAGNITUDE = 1e-6f;
+
+void StickProcessor::process(float* x, float* y, const float* deadzone, const int count, const bool scaled, const float outerDeadzone, const float antiDeadzone)
+{
+	int i = 0;
+
+	const float outer = (outerDeadzone > MIN_MAGNITUDE) ? outerDeadzone : 1.0f;
+	const float anti = scaled ? antiDeadzone : 0;
+
+#if defined(STICK_PROCESSOR_AVX)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 minMagnitude = _mm256_set1_ps(MIN_MAGNITUDE);
+		const __m256 outerValue = _mm256_set1_ps(outer);
+		const __m256 antiValue = _mm256_set1_ps(anti);
+		const __m256 antiRange = _mm256_set1_ps(1.0f - anti);
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 vx = _mm256_loadu_ps(x + i);
+			const __m256 vy = _mm256_loadu_ps(y + i);
+			const __m256 dz = _mm256_loadu_ps(deadzone + i);
+
+			const __m256 magnitude = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+			const __m256 outside = _mm256_cmp_ps(magnitude, dz, _CMP_GE_OQ);
+
+			__m256 newMagnitude;
+			if (scaled)
+			{
+				// (magnitude - deadzone) / (outer - deadzone), mapped to anti ~ 1
+				const __m256 range = _mm256_max_ps(_mm256_sub_ps(outerValue, dz), minMagnitude);
+				__m256 t = _mm256_div_ps(_mm256_sub_ps(magnitude, dz), range);
+				t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+				newMagnitude = _mm256_add_ps(antiValue, _mm256_mul_ps(antiRange, t));
+			}
+			else
+			{
+				newMagnitude = _mm256_min_ps(_mm256_div_ps(magnitude, outerValue), one);
+			}
+
+			const __m256 factor = _mm256_and_ps(outside, _mm256_div_ps(newMagnitude, _mm256_max_ps(magnitude, minMagnitude)));
+
+			_mm256_storeu_ps(x + i, _mm256_mul_ps(vx, factor));
+			_mm256_storeu_ps(y + i, _mm256_mul_ps(vy, factor));
+		}
+	}
+#endif
+
+#if defined(STICK_PROCESSOR_SSE)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minMagnitude = _mm_set1_ps(MIN_MAGNITUDE);
+		const __m128 outerValue = _mm_set1_ps(outer);
+		const __m128 antiValue = _mm_set1_ps(anti);
+		const __m128 antiRange = _mm_set1_ps(1.0f - anti);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 vx = _mm_loadu_ps(x + i);
+			const __m128 vy = _mm_loadu_ps(y + i);
+			const __m128 dz = _mm_loadu_ps(deadzone + i);
+
+			const __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+			const __m128 outside = _mm_cmpge_ps(magnitude, dz);
+
+			__m128 newMagnitude;
+			if (scaled)
+			{
+				const __m128 range = _mm_max_ps(_mm_sub_ps(outerValue, dz), minMagnitude);
+				__m128 t = _mm_div_ps(_mm_sub_ps(magnitude, dz), range);
+				t = _mm_min_ps(_mm_max_ps(t, zero), one);
+				newMagnitude = _mm_add_ps(antiValue, _mm_mul_ps(antiRange, t));
+			}
+			else
+			{
+				newMagnitude = _mm_min_ps(_mm_div_ps(magnitude, outerValue), one);
+			}
+
+			const __m128 factor = _mm_and_ps(outside, _mm_div_ps(newMagnitude, _mm_max_ps(magnitude, minMagnitude)));
+
+			_mm_storeu_ps(x + i, _mm_mul_ps(vx, factor));
+			_mm_storeu_ps(y + i, _mm_mul_ps(vy, factor));
+		}
+	}
+#endif
+
+	// Rest of sticks, or all sticks if there's no SIMD
+	processScalar(x, y, deadzone, i, count, scaled, outer, anti);
+}
+
+void StickProcessor::processScalar(float* x, float* y, const float* deadzone, const int begin, const int end, const bool scaled, const float outerDeadzone, const float antiDeadzone)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const float magnitude = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+
+		if (magnitude < deadzone[i])
+		{
+			x[i] = 0;
+			y[i] = 0;
+			continue;
+		}
+
+		float newMagnitude = 0;
+		if (scaled)
+		{
+			float range = outerDeadzone - deadzone[i];
+			if (range < MIN_MAGNITUDE)
+			{
+				range = MIN_MAGNITUDE;
+			}
+
+			float t = (magnitude - deadzone[i]) / range;
+			if (t < 0)
+			{
+				t = 0;
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+			}
+
+			newMagnitude = antiDeadzone + (1.0f - antiDeadzone) * t;
+		}
+		else
+		{
+			newMagnitude = magnitude / outerDeadzone;
+			if (newMagnitude > 1.0f)
+			{
+				newMagnitude = 1.0f;
+			}
+		}
+
+		const float factor = newMagnitude / (magnitude > MIN_MAGNITUDE ? magnitude : MIN_MAGNITUDE);
+		x[i] *= factor;
+		y[i] *= factor;
+	}
+}
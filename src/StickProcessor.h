@@ -0,0 +1,39 @@
+#ifndef STICK_PROCESSOR_H
+#define STICK_PROCESSOR_H
+
+/**
+*	@class StickProcessor
+*
+*	@brief Processes 2D stick vectors of many sticks at once.
+*
+*	Sticks are given as SoA arrays (x, y and deadzone of each stick are stored in separate arrays)
+*	so that all sticks of all controllers are processed in single SIMD pass.
+*	Uses AVX (8 sticks) or SSE (4 sticks) if compiler targets it, and scalar for the rest.
+*
+*	Modes
+*	- Radial: Zero inside deadzone circle. Outside, vector is kept and scaled to reach 1 at outer ring.
+*	- Scaled radial: Same but magnitude between deadzone and outer ring is rescaled to antiDeadzone ~ 1,
+*	  so there is no jump at deadzone boundary.
+*
+*	Either way, magnitude is clamped to 1 so corners of square gate don't exceed unit circle.
+*/
+class StickProcessor
+{
+public:
+	/**
+	*	Process sticks in place.
+	*	@param x, y Normalized raw value (-1 ~ 1) of each stick. Overwritten with result.
+	*	@param deadzone Normalized deadzone radius of each stick.
+	*	@param count Number of sticks.
+	*	@param scaled True for scaled radial, false for radial.
+	*	@param outerDeadzone Radius that maps to full tilt. (0 ~ 1]
+	*	@param antiDeadzone Minimum output magnitude outside deadzone. Only used when scaled. [0 ~ 1)
+	*/
+	static void process(float* x, float* y, const float* deadzone, const int count, const bool scaled, const float outerDeadzone, const float antiDeadzone);
+
+private:
+	// Process sticks from begin to end one by one.
+	static void processScalar(float* x, float* y, const float* deadzone, const int begin, const int end, const bool scaled, const float outerDeadzone, const float antiDeadzone);
+};
+
+#endif
@@ -91,7 +91,8 @@ int main(int argc, char **argv)
 	
 	while (run)
 	{
-		cm->update();
+		// Sleep until input arrives instead of spinning. Wake up every second anyway.
+		cm->waitForInput(1000);
 	}
 
 	system("pause");